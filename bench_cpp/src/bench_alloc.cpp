@@ -0,0 +1,117 @@
+// Global operator new/delete replacement for allocation profiling. Only
+// compiled into the binaries when BENCH_ALLOC_PROFILE is enabled.
+
+#include "bench_alloc.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+struct alignas(64) RoleCounters {
+    std::atomic<std::uint64_t> allocs{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> frees{0};
+};
+
+RoleCounters g_counters[bench::alloc::kNumRoles];
+thread_local int t_role = static_cast<int>(bench::alloc::ThreadRole::kOther);
+
+inline void count_alloc(std::size_t size) {
+    RoleCounters& c = g_counters[t_role];
+    c.allocs.fetch_add(1, std::memory_order_relaxed);
+    c.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+inline void count_free(void* p) {
+    if (p) g_counters[t_role].frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* do_alloc(std::size_t size) {
+    count_alloc(size);
+    if (size == 0) size = 1;
+    return std::malloc(size);
+}
+
+void* do_alloc_aligned(std::size_t size, std::size_t align) {
+    count_alloc(size);
+    if (size == 0) size = 1;
+    if (align < sizeof(void*)) align = sizeof(void*);
+    void* p = nullptr;
+    if (posix_memalign(&p, align, size) != 0) return nullptr;
+    return p;
+}
+
+void do_free(void* p) {
+    count_free(p);
+    std::free(p);
+}
+
+}  // namespace
+
+namespace bench {
+namespace alloc {
+
+void set_thread_role(ThreadRole role) { t_role = static_cast<int>(role); }
+
+Snapshot snapshot() {
+    Snapshot s;
+    for (int i = 0; i < kNumRoles; ++i) {
+        s.role[i].allocs = g_counters[i].allocs.load(std::memory_order_relaxed);
+        s.role[i].bytes = g_counters[i].bytes.load(std::memory_order_relaxed);
+        s.role[i].frees = g_counters[i].frees.load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+}  // namespace alloc
+}  // namespace bench
+
+void* operator new(std::size_t size) {
+    void* p = do_alloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    void* p = do_alloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return do_alloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return do_alloc(size); }
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    void* p = do_alloc_aligned(size, static_cast<std::size_t>(align));
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    void* p = do_alloc_aligned(size, static_cast<std::size_t>(align));
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return do_alloc_aligned(size, static_cast<std::size_t>(align));
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return do_alloc_aligned(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void* p) noexcept { do_free(p); }
+void operator delete[](void* p) noexcept { do_free(p); }
+void operator delete(void* p, std::size_t) noexcept { do_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { do_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { do_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { do_free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { do_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { do_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { do_free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { do_free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { do_free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { do_free(p); }
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+// Opt-in heap allocation accounting. When built with -DBENCH_ALLOC_PROFILE=ON,
+// bench_alloc.cpp replaces the global operator new/delete and counts every
+// allocation against the role of the calling thread. Otherwise all of this
+// compiles to no-ops.
+
+namespace bench {
+namespace alloc {
+
+enum class ThreadRole : int { kOther = 0, kSender = 1, kReceive = 2 };
+static constexpr int kNumRoles = 3;
+
+struct Counts {
+    std::uint64_t allocs = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t frees = 0;
+};
+
+struct Snapshot {
+    Counts role[kNumRoles];
+
+    Snapshot operator-(const Snapshot& o) const {
+        Snapshot d;
+        for (int i = 0; i < kNumRoles; ++i) {
+            d.role[i].allocs = role[i].allocs - o.role[i].allocs;
+            d.role[i].bytes = role[i].bytes - o.role[i].bytes;
+            d.role[i].frees = role[i].frees - o.role[i].frees;
+        }
+        return d;
+    }
+};
+
+#if defined(BENCH_ALLOC_PROFILE)
+void set_thread_role(ThreadRole role);
+Snapshot snapshot();
+inline constexpr bool enabled() { return true; }
+#else
+inline void set_thread_role(ThreadRole) {}
+inline Snapshot snapshot() { return Snapshot{}; }
+inline constexpr bool enabled() { return false; }
+#endif
+
+inline const char* role_label(int role) {
+    switch (role) {
+        case static_cast<int>(ThreadRole::kSender): return "发送线程";
+        case static_cast<int>(ThreadRole::kReceive): return "回调/接收线程";
+        default: return "其他线程";
+    }
+}
+
+// Prints per-message allocation figures for a measurement window. Expects the
+// stream to already be in fixed format. Prints nothing when profiling is off.
+inline void print_summary(std::ostream& os, const Snapshot& delta, std::uint64_t msgs) {
+    if (!enabled()) return;
+    const double n = static_cast<double>(msgs);
+    for (int i = 0; i < kNumRoles; ++i) {
+        const Counts& c = delta.role[i];
+        os << "堆分配（" << role_label(i) << "）: " << c.allocs << " 次 / " << c.bytes << " 字节，每条 "
+           << ((msgs > 0) ? (static_cast<double>(c.allocs) / n) : 0.0) << " 次 / "
+           << ((msgs > 0) ? (static_cast<double>(c.bytes) / n) : 0.0) << " 字节（释放 " << c.frees
+           << " 次）\n";
+    }
+}
+
+}  // namespace alloc
+}  // namespace bench
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench_numfile.hpp"
+
+namespace bench {
+
+// Arrival process driving the sender's intended send times.
+//   fixed   - perfectly periodic at --rate-hz (original behavior)
+//   poisson - exponential inter-arrival times with mean 1/--rate-hz
+//   burst   - on/off: --burst-size messages spaced --burst-gap-us apart, then
+//             idle so that the long-run average stays at --rate-hz
+//   trace   - replay of recorded inter-arrival times (us, one per line), looped
+enum class ArrivalProfile { kFixed, kPoisson, kBurst, kTrace };
+
+inline const char* arrival_profile_name(ArrivalProfile p) {
+    switch (p) {
+        case ArrivalProfile::kFixed: return "fixed";
+        case ArrivalProfile::kPoisson: return "poisson";
+        case ArrivalProfile::kBurst: return "burst";
+        case ArrivalProfile::kTrace: return "trace";
+    }
+    return "?";
+}
+
+inline bool parse_arrival_profile(const std::string& s, ArrivalProfile& out) {
+    if (s == "fixed") {
+        out = ArrivalProfile::kFixed;
+    } else if (s == "poisson") {
+        out = ArrivalProfile::kPoisson;
+    } else if (s == "burst") {
+        out = ArrivalProfile::kBurst;
+    } else if (s == "trace") {
+        out = ArrivalProfile::kTrace;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+class ArrivalProcess {
+   public:
+    using Gap = std::chrono::nanoseconds;
+
+    ArrivalProcess(ArrivalProfile profile, int rate_hz, std::uint64_t burst_size, double burst_gap_us)
+        : profile_(profile),
+          mean_gap_ns_(1e9 / static_cast<double>(rate_hz)),
+          burst_size_(burst_size ? burst_size : 1),
+          burst_gap_ns_(burst_gap_us * 1000.0),
+          rng_(std::random_device{}()) {}
+
+    // Reads one inter-arrival time (us) per line, see read_number_file().
+    bool load_trace(const std::string& path, std::string& err) {
+        std::vector<double> gaps_us;
+        if (!read_number_file(path, gaps_us, err)) return false;
+        trace_ns_.clear();
+        double sum_ns = 0.0;
+        for (double v : gaps_us) {
+            trace_ns_.push_back(v * 1000.0);
+            sum_ns += v * 1000.0;
+        }
+        if (trace_ns_.empty()) {
+            err = "no inter-arrival times in " + path;
+            return false;
+        }
+        // An all-zero trace has no finite rate: it would replay as a flood and
+        // leave mean_rate_hz() at 0.
+        if (!(sum_ns > 0.0)) {
+            err = "inter-arrival times in " + path + " sum to 0";
+            trace_ns_.clear();
+            return false;
+        }
+        return true;
+    }
+
+    ArrivalProfile profile() const { return profile_; }
+    std::size_t trace_size() const { return trace_ns_.size(); }
+
+    // Long-run average rate implied by the profile (msg/s).
+    double mean_rate_hz() const {
+        if (profile_ == ArrivalProfile::kTrace && !trace_ns_.empty()) {
+            double sum = 0.0;
+            for (double v : trace_ns_) sum += v;
+            return (sum > 0.0) ? (1e9 * static_cast<double>(trace_ns_.size()) / sum) : 0.0;
+        }
+        return 1e9 / mean_gap_ns_;
+    }
+
+    // Time between the previous intended send and the next one.
+    Gap next_gap() {
+        double ns = mean_gap_ns_;
+        switch (profile_) {
+            case ArrivalProfile::kFixed:
+                break;
+            case ArrivalProfile::kPoisson:
+                ns = exp_(rng_) * mean_gap_ns_;
+                break;
+            case ArrivalProfile::kBurst: {
+                const double period_ns = mean_gap_ns_ * static_cast<double>(burst_size_);
+                const double in_burst_ns = burst_gap_ns_ * static_cast<double>(burst_size_ - 1);
+                if (++burst_pos_ < burst_size_) {
+                    ns = burst_gap_ns_;
+                } else {
+                    burst_pos_ = 0;
+                    ns = (period_ns > in_burst_ns) ? (period_ns - in_burst_ns) : 0.0;
+                }
+                break;
+            }
+            case ArrivalProfile::kTrace:
+                ns = trace_ns_[trace_pos_];
+                trace_pos_ = (trace_pos_ + 1) % trace_ns_.size();
+                break;
+        }
+        return Gap(static_cast<Gap::rep>(ns));
+    }
+
+   private:
+    ArrivalProfile profile_;
+    double mean_gap_ns_;
+    std::uint64_t burst_size_;
+    double burst_gap_ns_;
+    std::uint64_t burst_pos_ = 0;
+    std::vector<double> trace_ns_;
+    std::size_t trace_pos_ = 0;
+    std::mt19937_64 rng_;
+    std::exponential_distribution<double> exp_{1.0};
+};
+
+}  // namespace bench
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+// getrusage() figures: CPU split into user/sys plus context switches.
+struct CpuUsage {
+    std::uint64_t user_ns = 0;
+    std::uint64_t sys_ns = 0;
+    std::int64_t voluntary_cs = 0;
+    std::int64_t involuntary_cs = 0;
+
+    std::uint64_t cpu_ns() const { return user_ns + sys_ns; }
+
+    CpuUsage& operator+=(const CpuUsage& o) {
+        user_ns += o.user_ns;
+        sys_ns += o.sys_ns;
+        voluntary_cs += o.voluntary_cs;
+        involuntary_cs += o.involuntary_cs;
+        return *this;
+    }
+
+    CpuUsage operator-(const CpuUsage& o) const {
+        CpuUsage d;
+        d.user_ns = user_ns - o.user_ns;
+        d.sys_ns = sys_ns - o.sys_ns;
+        d.voluntary_cs = voluntary_cs - o.voluntary_cs;
+        d.involuntary_cs = involuntary_cs - o.involuntary_cs;
+        return d;
+    }
+};
+
+inline std::uint64_t timeval_ns(const timeval& tv) {
+    return static_cast<std::uint64_t>(tv.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(tv.tv_usec) * 1000ull;
+}
+
+inline CpuUsage read_usage(int who) {
+    CpuUsage u;
+    rusage ru{};
+    if (getrusage(who, &ru) != 0) return u;
+    u.user_ns = timeval_ns(ru.ru_utime);
+    u.sys_ns = timeval_ns(ru.ru_stime);
+    u.voluntary_cs = ru.ru_nvcsw;
+    u.involuntary_cs = ru.ru_nivcsw;
+    return u;
+}
+
+// Whole process, all threads.
+inline CpuUsage process_usage() { return read_usage(RUSAGE_SELF); }
+
+// Calling thread only (Linux); elsewhere falls back to the process figures.
+inline CpuUsage thread_usage() {
+#if defined(RUSAGE_THREAD)
+    return read_usage(RUSAGE_THREAD);
+#else
+    return read_usage(RUSAGE_SELF);
+#endif
+}
+
+// One "<label> CPU: ..." summary line for a thread (or a group of threads).
+inline void print_thread_usage(std::ostream& os, const std::string& label, const CpuUsage& u) {
+    os << label << " CPU: " << (u.cpu_ns() / 1e9) << " 秒，上下文切换 自愿 " << u.voluntary_cs << " / 非自愿 "
+       << u.involuntary_cs << " 次\n";
+}
+
+// Hardware counters (cycles, instructions, cache misses) for every thread that
+// exists when start() is called, via perf_event_open. User-space only so it
+// works under the default perf_event_paranoid=2. Threads spawned after
+// start() are not counted.
+class PerfCounters {
+   public:
+    PerfCounters() = default;
+    ~PerfCounters() { close_all(); }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool start() {
+#if defined(__linux__)
+        close_all();
+        DIR* dir = opendir("/proc/self/task");
+        if (!dir) {
+            error_ = std::string("opendir /proc/self/task: ") + std::strerror(errno);
+            return false;
+        }
+        while (dirent* ent = readdir(dir)) {
+            if (ent->d_name[0] == '.') continue;
+            const pid_t tid = static_cast<pid_t>(std::atoi(ent->d_name));
+            for (int k = 0; k < kNumEvents; ++k) {
+                const int fd = open_event(tid, kEvents[k]);
+                if (fd < 0) {
+                    if (error_.empty()) error_ = std::string("perf_event_open: ") + std::strerror(errno);
+                    continue;
+                }
+                fds_[k].push_back(fd);
+            }
+        }
+        closedir(dir);
+        for (int k = 0; k < kNumEvents; ++k) {
+            for (int fd : fds_[k]) ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        threads_ = fds_[0].size();
+        return available();
+#else
+        error_ = "perf_event_open not supported on this platform";
+        return false;
+#endif
+    }
+
+    void stop() {
+#if defined(__linux__)
+        for (int k = 0; k < kNumEvents; ++k) {
+            std::uint64_t total = 0;
+            for (int fd : fds_[k]) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+                total += read_scaled(fd);
+            }
+            values_[k] = total;
+        }
+        close_all();
+#endif
+    }
+
+    bool available() const { return threads_ > 0; }
+    const std::string& error() const { return error_; }
+    std::size_t threads() const { return threads_; }
+    std::uint64_t cycles() const { return values_[0]; }
+    std::uint64_t instructions() const { return values_[1]; }
+    std::uint64_t cache_misses() const { return values_[2]; }
+
+   private:
+    static constexpr int kNumEvents = 3;
+
+#if defined(__linux__)
+    static constexpr std::uint64_t kEvents[kNumEvents] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+    };
+
+    static int open_event(pid_t tid, std::uint64_t config) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0));
+    }
+
+    // Scale for multiplexing when the PMU is oversubscribed.
+    static std::uint64_t read_scaled(int fd) {
+        std::uint64_t buf[3] = {0, 0, 0};
+        if (read(fd, buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf))) return 0;
+        if (buf[2] == 0) return 0;
+        if (buf[2] >= buf[1]) return buf[0];
+        return static_cast<std::uint64_t>(static_cast<double>(buf[0]) * buf[1] / buf[2]);
+    }
+#endif
+
+    void close_all() {
+#if defined(__linux__)
+        for (auto& v : fds_) {
+            for (int fd : v) ::close(fd);
+            v.clear();
+        }
+#endif
+    }
+
+    std::vector<int> fds_[kNumEvents];
+    std::uint64_t values_[kNumEvents] = {0, 0, 0};
+    std::size_t threads_ = 0;
+    std::string error_;
+};
+
+// Measures what a benchmark window costs: process and calling-thread rusage,
+// plus hardware counters across the process' threads.
+class CostMeter {
+   public:
+    void begin() {
+        perf_.start();
+        proc0_ = process_usage();
+        thread0_ = thread_usage();
+    }
+
+    void end() {
+        proc_ = process_usage() - proc0_;
+        thread_ = thread_usage() - thread0_;
+        perf_.stop();
+    }
+
+    const CpuUsage& process() const { return proc_; }
+    const CpuUsage& thread() const { return thread_; }
+    const PerfCounters& perf() const { return perf_; }
+
+    // Prints the cost block of a summary. `thread_label` names the thread that
+    // called begin()/end(); pass nullptr when that thread does no real work.
+    // Expects the stream to already be in fixed format.
+    void print(std::ostream& os, std::uint64_t msgs, double dur_s, const char* thread_label) const {
+        const double cpu_us = static_cast<double>(proc_.cpu_ns()) / 1000.0;
+        const double n = static_cast<double>(msgs);
+        const double cs = static_cast<double>(proc_.voluntary_cs + proc_.involuntary_cs);
+
+        os << "进程 CPU: 用户态 " << (proc_.user_ns / 1e9) << " 秒，内核态 " << (proc_.sys_ns / 1e9)
+           << " 秒（占用 " << ((dur_s > 0.0) ? (cpu_us / 1e6 / dur_s * 100.0) : 0.0) << " %）\n"
+           << "每条消息 CPU: " << ((msgs > 0) ? (cpu_us / n) : 0.0) << " us，每 CPU 秒处理 "
+           << ((cpu_us > 0.0) ? (n / (cpu_us / 1e6)) : 0.0) << " 条\n"
+           << "上下文切换: 自愿 " << proc_.voluntary_cs << " 次，非自愿 " << proc_.involuntary_cs
+           << " 次（每千条 " << ((msgs > 0) ? (cs / n * 1000.0) : 0.0) << " 次）\n";
+        if (thread_label) print_thread_usage(os, thread_label, thread_);
+
+        if (perf_.available()) {
+            const double cyc = static_cast<double>(perf_.cycles());
+            const double ins = static_cast<double>(perf_.instructions());
+            const double miss = static_cast<double>(perf_.cache_misses());
+            os << "硬件计数器（用户态，" << perf_.threads() << " 个线程）: 每条 cycles "
+               << ((msgs > 0) ? (cyc / n) : 0.0) << "，instructions " << ((msgs > 0) ? (ins / n) : 0.0)
+               << "，cache-misses " << ((msgs > 0) ? (miss / n) : 0.0) << "，IPC "
+               << ((cyc > 0.0) ? (ins / cyc) : 0.0) << "\n";
+        } else {
+            os << "硬件计数器: 不可用（" << perf_.error() << "）\n";
+        }
+    }
+
+   private:
+    CpuUsage proc0_;
+    CpuUsage thread0_;
+    CpuUsage proc_;
+    CpuUsage thread_;
+    PerfCounters perf_;
+};
+
+}  // namespace bench
@@ -1,9 +1,15 @@
+#include "bench_alloc.hpp"
+#include "bench_cost.hpp"
 #include "bench_protocol.hpp"
+#include "bench_recv.hpp"
+#include "bench_service.hpp"
+#include "bench_session.hpp"
 #include "zenoh.hxx"
 
 #include <atomic>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <csignal>
 #include <cstdint>
 #include <cstdlib>
@@ -13,6 +19,7 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 using namespace zenoh;
 
@@ -43,6 +50,17 @@ struct Args {
     std::string connect = "tcp/127.0.0.1:7447";
     std::string req_key = bench::kDefaultReqKey;
     std::string ack_key = bench::kDefaultAckKey;
+    bench::RecvMode recv_mode = bench::RecvMode::kCallback;
+    std::size_t recv_queue = 1024;
+    int recv_cpu = -1;
+    bench::ServiceDist service_dist = bench::ServiceDist::kNone;
+    bench::ServiceMethod service_method = bench::ServiceMethod::kSpin;
+    double service_us = 0.0;
+    std::string service_file;
+    int service_concurrency = 1;
+    int sessions = 1;
+    double warmup_sec = 0.0;         // from the first request, excluded from stats
+    std::uint64_t warmup_count = 0;  // first requests excluded from stats
     bool quiet = false;
 };
 
@@ -69,14 +87,80 @@ bool parse_args(int argc, char** argv, Args& out) {
             const char* v = need("--ack-key");
             if (!v) return false;
             out.ack_key = v;
+        } else if (a == "--recv-mode") {
+            const char* v = need("--recv-mode");
+            if (!v) return false;
+            if (!bench::parse_recv_mode(v, out.recv_mode)) {
+                std::cerr << "Invalid --recv-mode: " << v << " (expected callback|fifo|ring-spin)\n";
+                return false;
+            }
+        } else if (a == "--recv-queue") {
+            const char* v = need("--recv-queue");
+            if (!v) return false;
+            out.recv_queue = static_cast<std::size_t>(std::strtoull(v, nullptr, 10));
+        } else if (a == "--recv-cpu") {
+            const char* v = need("--recv-cpu");
+            if (!v) return false;
+            out.recv_cpu = std::atoi(v);
+        } else if (a == "--service-dist") {
+            const char* v = need("--service-dist");
+            if (!v) return false;
+            if (!bench::parse_service_dist(v, out.service_dist)) {
+                std::cerr << "Invalid --service-dist: " << v << " (expected none|fixed|exp|empirical)\n";
+                return false;
+            }
+        } else if (a == "--service-us") {
+            const char* v = need("--service-us");
+            if (!v) return false;
+            out.service_us = std::atof(v);
+        } else if (a == "--service-file") {
+            const char* v = need("--service-file");
+            if (!v) return false;
+            out.service_file = v;
+        } else if (a == "--service-method") {
+            const char* v = need("--service-method");
+            if (!v) return false;
+            if (!bench::parse_service_method(v, out.service_method)) {
+                std::cerr << "Invalid --service-method: " << v << " (expected spin|sleep)\n";
+                return false;
+            }
+        } else if (a == "--service-concurrency") {
+            const char* v = need("--service-concurrency");
+            if (!v) return false;
+            out.service_concurrency = std::atoi(v);
+        } else if (a == "--sessions") {
+            const char* v = need("--sessions");
+            if (!v) return false;
+            out.sessions = std::atoi(v);
+        } else if (a == "--warmup-sec") {
+            const char* v = need("--warmup-sec");
+            if (!v) return false;
+            out.warmup_sec = std::atof(v);
+        } else if (a == "--warmup-count") {
+            const char* v = need("--warmup-count");
+            if (!v) return false;
+            out.warmup_count = static_cast<std::uint64_t>(std::strtoull(v, nullptr, 10));
         } else if (a == "--quiet") {
             out.quiet = true;
         } else if (a == "-h" || a == "--help") {
             std::cout
                 << "bench_echo_ack\n\n"
-                << "  --connect  <endpoint>   (default: tcp/127.0.0.1:7447)\n"
+                << "  --connect  <endpoint>   (default: tcp/127.0.0.1:7447; comma-separated list is\n"
+                << "                           assigned to sessions round-robin)\n"
                 << "  --req-key   <keyexpr>   (default: " << bench::kDefaultReqKey << ")\n"
                 << "  --ack-key   <keyexpr>   (default: " << bench::kDefaultAckKey << ")\n"
+                << "  --recv-mode <mode>      (callback|fifo|ring-spin, default: callback)\n"
+                << "  --recv-queue <int>      (fifo/ring capacity, default: 1024)\n"
+                << "  --recv-cpu  <int>       (pin drain thread to this CPU, default: none)\n"
+                << "  --service-dist <dist>   (none|fixed|exp|empirical, default: none)\n"
+                << "  --service-us <double>   (fixed / mean service time in us)\n"
+                << "  --service-file <path>   (empirical service times, us per line)\n"
+                << "  --service-method <m>    (spin|sleep, default: spin)\n"
+                << "  --service-concurrency <int> (drain threads serving in parallel, default: 1)\n"
+                << "  --sessions <int>        (sessions, must match bench_pub_rtt, default: 1)\n"
+                << "  --warmup-sec <double>   (exclude requests in the first seconds after the\n"
+                << "                           first request from stats, default: 0)\n"
+                << "  --warmup-count <uint64> (exclude the first requests from stats, default: 0)\n"
                 << "  --quiet                (disable per-message logs)\n";
             std::exit(0);
         } else {
@@ -99,72 +183,188 @@ void handle_signal(int) { g_running.store(false); }
 }  // namespace
 
 int main(int argc, char** argv) {
+    const auto process_start_tp = std::chrono::steady_clock::now();
     Args args;
     if (!parse_args(argc, argv, args)) return 2;
 
+    const std::vector<std::string> endpoints = bench::split_csv(args.connect);
+    if (endpoints.empty()) {
+        std::cerr << "--connect must name at least one endpoint\n";
+        return 2;
+    }
+    if (args.sessions <= 0) {
+        std::cerr << "--sessions must be > 0\n";
+        return 2;
+    }
+    if (args.service_concurrency <= 0) {
+        std::cerr << "--service-concurrency must be > 0\n";
+        return 2;
+    }
+    if (args.service_concurrency > 1 && args.recv_mode == bench::RecvMode::kCallback) {
+        std::cerr << "--service-concurrency > 1 requires --recv-mode fifo or ring-spin\n";
+        return 2;
+    }
+    // In callback mode every session's zenoh thread runs the handler, so
+    // service would be N-wide regardless of --service-concurrency. The queued
+    // modes funnel all sessions through one receiver and keep the limit.
+    if (args.sessions > 1 && args.recv_mode == bench::RecvMode::kCallback &&
+        args.service_dist != bench::ServiceDist::kNone) {
+        std::cerr << "--service-dist with --sessions > 1 requires --recv-mode fifo or ring-spin\n";
+        return 2;
+    }
+    bench::ServiceModel service(args.service_dist, args.service_method, args.service_us);
+    if (args.service_dist == bench::ServiceDist::kEmpirical) {
+        std::string err;
+        if (!service.load_empirical(args.service_file, err)) {
+            std::cerr << "--service-file: " << err << "\n";
+            return 2;
+        }
+    } else if (service.enabled() && args.service_us <= 0.0) {
+        std::cerr << "--service-us must be > 0 for --service-dist " << bench::service_dist_name(args.service_dist)
+                  << "\n";
+        return 2;
+    }
+    service.calibrate();
+
     std::signal(SIGINT, handle_signal);
     std::signal(SIGTERM, handle_signal);
 
     try {
-        Config config = Config::create_default();
-        const std::string endpoints_json = "[\"" + args.connect + "\"]";
-        config.insert_json5("connect/endpoints", endpoints_json);
-        auto session = Session::open(std::move(config));
+        using Clock = std::chrono::steady_clock;
+        auto ms_between = [](Clock::time_point a, Clock::time_point b) {
+            return std::chrono::duration<double, std::milli>(b - a).count();
+        };
 
-        auto ack_pub = session.declare_publisher(KeyExpr(args.ack_key));
+        const std::size_t n_sessions = static_cast<std::size_t>(args.sessions);
+        std::vector<Session> sessions;
+        std::vector<Publisher> ack_pubs;
+        sessions.reserve(n_sessions);
+        ack_pubs.reserve(n_sessions);
+        double open_ms = 0.0;
+        double declare_pub_ms = 0.0;
+        for (std::size_t i = 0; i < n_sessions; ++i) {
+            const auto t0 = Clock::now();
+            sessions.push_back(bench::open_session(endpoints[i % endpoints.size()]));
+            const auto t1 = Clock::now();
+            ack_pubs.push_back(
+                sessions.back().declare_publisher(KeyExpr(bench::session_key(args.ack_key, i, n_sessions))));
+            open_ms += ms_between(t0, t1);
+            declare_pub_ms += ms_between(t1, Clock::now());
+        }
 
         std::cout << "bench_echo_ack connected=" << args.connect << " req_key=" << args.req_key
-                  << " ack_key=" << args.ack_key << "\n";
-
-        using Clock = std::chrono::steady_clock;
+                  << " ack_key=" << args.ack_key << " recv_mode=" << bench::recv_mode_name(args.recv_mode)
+                  << " service=" << bench::service_dist_name(args.service_dist) << " sessions=" << n_sessions;
+        if (service.enabled()) {
+            std::cout << "/" << bench::service_method_name(args.service_method) << " service_us=" << args.service_us
+                      << " concurrency=" << args.service_concurrency;
+        }
+        std::cout << " warmup_sec=" << args.warmup_sec << " warmup_count=" << args.warmup_count << "\n";
+
+        // With several handler threads (a drain pool, or one zenoh callback
+        // thread per session) requests are handled out of arrival order, so
+        // inter-arrival gaps and sequence order would describe the threads, not
+        // zenoh. They are only tracked when a single thread runs the handler.
+        const bool single_handler = (args.recv_mode == bench::RecvMode::kCallback) ? (n_sessions == 1)
+                                                                                   : (args.service_concurrency == 1);
+        const bool track_order = single_handler;
         bool have_prev = false;
         Clock::time_point prev_tp{};
         OnlineStats interarrival_us{};
+        OnlineStats queue_us{};
+        OnlineStats service_us{};
         std::uint64_t recv_count = 0;
         std::uint64_t out_of_order = 0;
-        std::uint64_t last_seq = 0;
-        bool have_last_seq = false;
+        std::vector<std::uint64_t> session_recv(n_sessions, 0);
+        std::vector<std::uint64_t> last_seq(n_sessions, 0);
+        std::vector<bool> have_last_seq(n_sessions, false);
         std::size_t last_payload_bytes = 0;
         std::mutex mu;
+        std::condition_variable steady_cv;
+
+        // Warm-up is measured from the first request's arrival; warm-up requests
+        // are still answered but stay out of every statistic below.
+        const bool has_warmup = args.warmup_sec > 0.0 || args.warmup_count > 0;
+        bool have_first_req = false;
+        Clock::time_point first_req_tp{};
+        bool steady = !has_warmup;
+        Clock::time_point steady_start_tp{};
+        std::uint64_t warmup_recv = 0;
 
         const auto start_tp = Clock::now();
+        bench::CostMeter cost;
 
-        auto sub = session.declare_subscriber(
-            KeyExpr(args.req_key),
-            [&](const Sample& sample) {
-                const auto now_tp = Clock::now();
+        bench::SampleReceiver receiver(
+            args.recv_mode, args.recv_queue, args.recv_cpu,
+            [&](const bench::RecvSample& rs) {
+                const auto now_tp = Clock::time_point(std::chrono::nanoseconds(rs.arrival_ns));
+                const std::uint64_t start_ns = steady_now_ns();
+                const std::size_t si = rs.tag;
 
-                std::string payload = sample.get_payload().as_string();
                 bench::ReqHeader req{};
-                if (!bench::parse_req_payload(payload.data(), payload.size(), req)) {
+                if (!bench::parse_req_payload(rs.head, rs.head_len, req)) {
                     if (!args.quiet) {
-                        std::cerr << "Failed to parse req payload (len=" << payload.size() << ")\n";
+                        std::cerr << "Failed to parse req payload (len=" << rs.payload_len << ")\n";
                     }
                     return;
                 }
 
+                bool warm = false;
+                bool entered_steady = false;
                 {
+                    std::lock_guard<std::mutex> lk(mu);
+                    if (!have_first_req) {
+                        have_first_req = true;
+                        first_req_tp = now_tp;
+                    }
+                    if (!steady) {
+                        warm = warmup_recv < args.warmup_count ||
+                               std::chrono::duration<double>(now_tp - first_req_tp).count() < args.warmup_sec;
+                        if (warm) {
+                            ++warmup_recv;
+                        } else {
+                            steady = true;
+                            steady_start_tp = now_tp;
+                            entered_steady = true;
+                        }
+                    }
+                }
+                if (entered_steady) steady_cv.notify_all();
+
+                if (!warm) {
                     std::lock_guard<std::mutex> lk(mu);
                     ++recv_count;
-                    last_payload_bytes = payload.size();
-                    if (have_prev) {
-                        const auto dt =
-                            std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(now_tp - prev_tp);
-                        interarrival_us.add(dt.count());
-                    } else {
-                        have_prev = true;
+                    ++session_recv[si];
+                    last_payload_bytes = rs.payload_len;
+                    queue_us.add(static_cast<double>(start_ns - rs.arrival_ns) / 1000.0);
+
+                    if (track_order) {
+                        if (have_prev) {
+                            const auto dt = std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+                                now_tp - prev_tp);
+                            interarrival_us.add(dt.count());
+                        } else {
+                            have_prev = true;
+                        }
+                        prev_tp = now_tp;
+
+                        if (have_last_seq[si] && req.seq <= last_seq[si]) ++out_of_order;
+                        last_seq[si] = req.seq;
+                        have_last_seq[si] = true;
                     }
-                    prev_tp = now_tp;
+                }
 
-                    if (have_last_seq && req.seq <= last_seq) ++out_of_order;
-                    last_seq = req.seq;
-                    have_last_seq = true;
+                if (service.enabled()) {
+                    service.serve(service.next_us());
+                    const double served_us = static_cast<double>(steady_now_ns() - start_ns) / 1000.0;
+                    std::lock_guard<std::mutex> lk(mu);
+                    if (!warm) service_us.add(served_us);
                 }
 
-                const std::uint64_t srv_recv_ns = steady_now_ns();
+                const std::uint64_t srv_recv_ns = rs.arrival_ns;
                 const std::uint64_t srv_send_ns = steady_now_ns();
                 std::string ack = bench::make_ack_payload(req.seq, srv_recv_ns, srv_send_ns);
-                ack_pub.put(ack);
+                ack_pubs[si].put(ack);
 
                 if (!args.quiet && (req.seq % 1000 == 0)) {
                     std::uint64_t total = 0;
@@ -175,27 +375,96 @@ int main(int argc, char** argv) {
                     std::cout << "recv seq=" << req.seq << " total=" << total << "\n";
                 }
             },
-            closures::none);
-
-        (void)sub;
+            args.service_concurrency);
+        receiver.start();
+
+        const auto declare_sub_t0 = Clock::now();
+        std::vector<Subscriber<void>> subs;
+        subs.reserve(n_sessions);
+        for (std::size_t i = 0; i < n_sessions; ++i) {
+            const auto tag = static_cast<std::uint32_t>(i);
+            subs.push_back(sessions[i].declare_subscriber(
+                KeyExpr(bench::session_key(args.req_key, i, n_sessions)),
+                [&receiver, tag](const Sample& sample) {
+                    bench::alloc::set_thread_role(bench::alloc::ThreadRole::kReceive);
+                    std::string payload = sample.get_payload().as_string();
+                    receiver.offer(payload.data(), payload.size(), tag);
+                },
+                closures::none));
+        }
+        const auto decl_done_tp = Clock::now();
+        const double declare_sub_ms = ms_between(declare_sub_t0, decl_done_tp);
+
+        // CPU, perf counters and allocations cover the steady-state window only:
+        // with a warm-up they start once the handler reports the transition.
+        // Requests handled before the meters start are left out of the divisor.
+        bench::alloc::Snapshot alloc_start{};
+        bool metering = false;
+        Clock::time_point meter_start_tp{};
+        std::uint64_t meter_recv0 = 0;
+        auto start_meters = [&] {
+            receiver.reset_stats();
+            cost.begin();
+            alloc_start = bench::alloc::snapshot();
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                meter_recv0 = recv_count;
+            }
+            meter_start_tp = Clock::now();
+            metering = true;
+        };
+        if (!has_warmup) start_meters();
 
         while (g_running.load()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            if (metering) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                continue;
+            }
+            bool ready = false;
+            {
+                std::unique_lock<std::mutex> lk(mu);
+                ready = steady_cv.wait_for(lk, std::chrono::milliseconds(200), [&] { return steady; });
+            }
+            if (ready) start_meters();
         }
+        if (!metering) start_meters();  // never left warm-up: empty window
 
+        receiver.stop();
         const auto end_tp = Clock::now();
-        const double dur_s =
-            std::chrono::duration_cast<std::chrono::duration<double>>(end_tp - start_tp).count();
+        cost.end();
+        const auto alloc_delta = bench::alloc::snapshot() - alloc_start;
+        const double run_s = std::chrono::duration_cast<std::chrono::duration<double>>(end_tp - start_tp).count();
+        const double meter_s = std::chrono::duration<double>(end_tp - meter_start_tp).count();
         std::uint64_t recv_count_snapshot = 0;
         std::uint64_t out_of_order_snapshot = 0;
         std::size_t payload_bytes_snapshot = 0;
         OnlineStats interarrival_snapshot{};
+        OnlineStats queue_snapshot{};
+        OnlineStats service_snapshot{};
+        std::vector<std::uint64_t> session_recv_snapshot;
         {
             std::lock_guard<std::mutex> lk(mu);
             recv_count_snapshot = recv_count;
             out_of_order_snapshot = out_of_order;
             payload_bytes_snapshot = last_payload_bytes;
             interarrival_snapshot = interarrival_us;
+            queue_snapshot = queue_us;
+            service_snapshot = service_us;
+            session_recv_snapshot = session_recv;
+        }
+        bool have_first_req_snapshot = false;
+        Clock::time_point first_req_snapshot{};
+        std::uint64_t warmup_recv_snapshot = 0;
+        double dur_s = run_s;
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            have_first_req_snapshot = have_first_req;
+            first_req_snapshot = first_req_tp;
+            warmup_recv_snapshot = warmup_recv;
+            // Rates cover the steady-state window only.
+            if (has_warmup) {
+                dur_s = steady ? std::chrono::duration<double>(end_tp - steady_start_tp).count() : 0.0;
+            }
         }
 
         const double msg_per_s =
@@ -214,10 +483,24 @@ int main(int argc, char** argv) {
                   << "运行时长: " << dur_s << " 秒\n"
                   << "收到请求: " << recv_count_snapshot << " 条\n"
                   << "处理速率: " << msg_per_s << " 条/秒\n"
-                  << "吞吐量: " << mb_per_s << " MiB/秒（payload=" << payload_bytes_snapshot << " 字节）\n"
-                  << "乱序请求: " << out_of_order_snapshot << " 条\n";
+                  << "吞吐量: " << mb_per_s << " MiB/秒（payload=" << payload_bytes_snapshot << " 字节）\n";
+        if (track_order) {
+            std::cout << "乱序请求: " << out_of_order_snapshot << " 条\n";
+        } else {
+            std::cout << "乱序请求: 不统计（多个线程并行处理，处理顺序不等于到达顺序）\n";
+        }
+
+        if (n_sessions > 1) {
+            for (std::size_t i = 0; i < n_sessions; ++i) {
+                std::cout << "会话 " << i << "（" << endpoints[i % endpoints.size()] << "）: 收到 " << session_recv_snapshot[i]
+                          << " 条，" << ((dur_s > 0.0) ? (static_cast<double>(session_recv_snapshot[i]) / dur_s) : 0.0)
+                          << " 条/秒\n";
+            }
+        }
 
-        if (interarrival_snapshot.n > 0) {
+        if (!track_order) {
+            std::cout << "到达间隔: 不统计（多个线程并行处理）\n";
+        } else if (interarrival_snapshot.n > 0) {
             std::cout << "到达间隔（微秒 us）: 平均 " << interarrival_snapshot.mean << "，最小 " << interarrival_snapshot.min_v
                       << "，最大 " << interarrival_snapshot.max_v
                       << "（约 " << (interarrival_snapshot.max_v / 1000.0) << " ms）\n"
@@ -226,6 +509,59 @@ int main(int argc, char** argv) {
             std::cout << "到达间隔: 无有效样本\n";
         }
 
+        if (queue_snapshot.n > 0) {
+            std::cout << "排队延迟（微秒 us）: 平均 " << queue_snapshot.mean << "，最大 " << queue_snapshot.max_v
+                      << "，标准差 " << queue_snapshot.stddev() << "\n";
+        }
+        if (service.enabled()) {
+            std::cout << "服务时间模型: " << bench::service_dist_name(args.service_dist) << "/"
+                      << bench::service_method_name(args.service_method) << "，并发上限 " << args.service_concurrency;
+            if (args.service_dist == bench::ServiceDist::kEmpirical) {
+                std::cout << "，经验样本 " << service.empirical_size() << " 个";
+            } else {
+                std::cout << "，设定 " << args.service_us << " us";
+            }
+            std::cout << "\n";
+            if (service_snapshot.n > 0) {
+                std::cout << "服务时间（微秒 us）: 平均 " << service_snapshot.mean << "，最小 " << service_snapshot.min_v
+                          << "，最大 " << service_snapshot.max_v << "，标准差 " << service_snapshot.stddev() << "\n";
+            }
+            const double rho = (dur_s > 0.0)
+                                   ? (service_snapshot.mean * static_cast<double>(service_snapshot.n) / 1e6 / dur_s /
+                                      static_cast<double>(args.service_concurrency) * 100.0)
+                                   : 0.0;
+            std::cout << "服务利用率: " << rho << " %\n";
+        }
+
+        std::cout << "启动耗时（毫秒 ms）: 进程启动到声明完成 " << ms_between(process_start_tp, decl_done_tp)
+                  << "，打开会话 " << open_ms << "，声明发布者 " << declare_pub_ms << "，声明订阅者 " << declare_sub_ms
+                  << "\n";
+        if (have_first_req_snapshot) {
+            std::cout << "首个请求（毫秒 ms）: 距声明完成 " << ms_between(decl_done_tp, first_req_snapshot)
+                      << "，距进程启动 " << ms_between(process_start_tp, first_req_snapshot) << "\n";
+        } else {
+            std::cout << "首个请求: 未收到\n";
+        }
+        if (has_warmup) {
+            std::cout << "预热（不计入统计，仍回 ACK）: " << warmup_recv_snapshot << " 条\n";
+        }
+
+        std::cout << "接收模式: " << bench::recv_mode_name(args.recv_mode) << "\n";
+        const std::uint64_t metered_recv = recv_count_snapshot - meter_recv0;
+        cost.print(std::cout, metered_recv, meter_s, nullptr);
+        bench::alloc::print_summary(std::cout, alloc_delta, metered_recv);
+        if (args.recv_mode != bench::RecvMode::kCallback) {
+            // The drain threads run the handler, so they carry the per-request cost.
+            std::string label = "接收线程";
+            if (receiver.workers() > 1) label += "（" + std::to_string(receiver.workers()) + " 个）";
+            if (receiver.pinned()) label += "（已绑核 " + std::to_string(args.recv_cpu) + " 起）";
+            bench::print_thread_usage(std::cout, label, receiver.drain_usage());
+            std::cout << "队列交接延迟（微秒 us）: 平均 " << receiver.handoff_avg_us() << "，最大 "
+                      << receiver.handoff_max_us() << "\n"
+                      << "最大队列深度: " << receiver.max_depth() << " 条\n"
+                      << "队列丢弃: " << receiver.dropped() << " 条\n";
+        }
+
         std::cout.flags(old_flags);
         std::cout.precision(old_prec);
     } catch (const std::exception& e) {
@@ -0,0 +1,378 @@
+#include "bench_cost.hpp"
+#include "bench_protocol.hpp"
+#include "bench_session.hpp"
+#include "zenoh.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace zenoh;
+
+namespace {
+
+// Upper bound on latency samples kept for percentiles (32 MiB of doubles).
+constexpr std::uint64_t kMaxLatencySamples = 1ull << 22;
+
+struct OnlineStats {
+    std::uint64_t n = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    double min_v = std::numeric_limits<double>::infinity();
+    double max_v = -std::numeric_limits<double>::infinity();
+
+    void add(double x) {
+        ++n;
+        if (x < min_v) min_v = x;
+        if (x > max_v) max_v = x;
+        const double delta = x - mean;
+        mean += delta / static_cast<double>(n);
+        const double delta2 = x - mean;
+        m2 += delta * delta2;
+    }
+
+    double variance() const { return (n >= 2) ? (m2 / static_cast<double>(n - 1)) : 0.0; }
+    double stddev() const { return std::sqrt(variance()); }
+};
+
+struct Args {
+    std::string connect = "tcp/127.0.0.1:7447";
+    std::string key_prefix = "fleet";
+    std::vector<std::uint64_t> keys = {100};      // K, one run per value
+    std::vector<std::uint64_t> subs = {1};        // S, one run per value
+    std::uint64_t fanout = 100;                   // nodes per group in the key hierarchy
+    std::vector<std::string> sub_patterns;        // default: <prefix>/g{i}/**
+    int rate_hz = 1000;
+    std::size_t payload_bytes = bench::kPayloadBytes;
+    std::uint64_t count = 10000;                  // messages per run
+    int settle_ms = 500;
+    int drain_ms = 200;
+    bool single_session = false;
+};
+
+bool parse_u64_list(const char* v, std::vector<std::uint64_t>& out) {
+    out.clear();
+    for (const auto& item : bench::split_csv(v)) {
+        const std::uint64_t x = static_cast<std::uint64_t>(std::strtoull(item.c_str(), nullptr, 10));
+        if (x == 0) return false;
+        out.push_back(x);
+    }
+    return !out.empty();
+}
+
+bool parse_args(int argc, char** argv, Args& out) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto need = [&](const char* name) -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << name << "\n";
+                return nullptr;
+            }
+            return argv[++i];
+        };
+
+        if (a == "--connect") {
+            const char* v = need("--connect");
+            if (!v) return false;
+            out.connect = v;
+        } else if (a == "--key-prefix") {
+            const char* v = need("--key-prefix");
+            if (!v) return false;
+            out.key_prefix = v;
+        } else if (a == "--keys") {
+            const char* v = need("--keys");
+            if (!v) return false;
+            if (!parse_u64_list(v, out.keys)) {
+                std::cerr << "Invalid --keys: " << v << "\n";
+                return false;
+            }
+        } else if (a == "--subs") {
+            const char* v = need("--subs");
+            if (!v) return false;
+            if (!parse_u64_list(v, out.subs)) {
+                std::cerr << "Invalid --subs: " << v << "\n";
+                return false;
+            }
+        } else if (a == "--fanout") {
+            const char* v = need("--fanout");
+            if (!v) return false;
+            out.fanout = static_cast<std::uint64_t>(std::strtoull(v, nullptr, 10));
+        } else if (a == "--sub-pattern") {
+            const char* v = need("--sub-pattern");
+            if (!v) return false;
+            out.sub_patterns.push_back(v);
+        } else if (a == "--rate-hz") {
+            const char* v = need("--rate-hz");
+            if (!v) return false;
+            out.rate_hz = std::atoi(v);
+        } else if (a == "--payload-bytes") {
+            const char* v = need("--payload-bytes");
+            if (!v) return false;
+            out.payload_bytes = static_cast<std::size_t>(std::strtoull(v, nullptr, 10));
+        } else if (a == "--count") {
+            const char* v = need("--count");
+            if (!v) return false;
+            out.count = static_cast<std::uint64_t>(std::strtoull(v, nullptr, 10));
+        } else if (a == "--settle-ms") {
+            const char* v = need("--settle-ms");
+            if (!v) return false;
+            out.settle_ms = std::atoi(v);
+        } else if (a == "--drain-ms") {
+            const char* v = need("--drain-ms");
+            if (!v) return false;
+            out.drain_ms = std::atoi(v);
+        } else if (a == "--single-session") {
+            out.single_session = true;
+        } else if (a == "-h" || a == "--help") {
+            std::cout
+                << "bench_keyspace\n\n"
+                << "  --connect         <endpoint>  (default: tcp/127.0.0.1:7447; with a comma-separated\n"
+                << "                                 list the subscriber session uses the second one)\n"
+                << "  --key-prefix      <chunk>     (default: fleet)\n"
+                << "  --keys            <list>      (publishers K, comma-separated sweep, default: 100)\n"
+                << "  --subs            <list>      (subscribers S, comma-separated sweep, default: 1)\n"
+                << "  --fanout          <uint64>    (keys per group, default: 100)\n"
+                << "  --sub-pattern     <keyexpr>   (repeatable; {i} = subscriber index mod groups,\n"
+                << "                                 default: <prefix>/g{i}/**)\n"
+                << "  --rate-hz         <int>       (total publish rate, default: 1000)\n"
+                << "  --payload-bytes   <int>       (default: " << bench::kPayloadBytes
+                << ", must be >= " << sizeof(bench::ReqHeader) << ")\n"
+                << "  --count           <uint64>    (messages per run, default: 10000)\n"
+                << "  --settle-ms       <int>       (wait after declarations, default: 500)\n"
+                << "  --drain-ms        <int>       (wait for late deliveries, default: 200)\n"
+                << "  --single-session             (publish and subscribe on one session)\n";
+            std::exit(0);
+        } else {
+            std::cerr << "Unknown arg: " << a << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class T>
+double percentile_sorted(const std::vector<T>& sorted, double p01) {
+    if (sorted.empty()) return 0.0;
+    if (p01 <= 0.0) return static_cast<double>(sorted.front());
+    if (p01 >= 1.0) return static_cast<double>(sorted.back());
+    const double idx = p01 * static_cast<double>(sorted.size() - 1);
+    const std::size_t i = static_cast<std::size_t>(idx);
+    return static_cast<double>(sorted[i]);
+}
+
+std::uint64_t steady_now_ns() {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+// Publisher i lives at <prefix>/g<i / fanout>/n<i % fanout>/telemetry.
+std::string publisher_key(const Args& args, std::uint64_t i) {
+    return args.key_prefix + "/g" + std::to_string(i / args.fanout) + "/n" + std::to_string(i % args.fanout) +
+           "/telemetry";
+}
+
+std::string subscriber_key(const Args& args, std::uint64_t i, std::uint64_t groups) {
+    const std::string pattern =
+        args.sub_patterns.empty() ? (args.key_prefix + "/g{i}/**") : args.sub_patterns[i % args.sub_patterns.size()];
+    std::string out = pattern;
+    const std::string idx = std::to_string(i % groups);
+    for (std::size_t pos = out.find("{i}"); pos != std::string::npos; pos = out.find("{i}", pos)) {
+        out.replace(pos, 3, idx);
+        pos += idx.size();
+    }
+    return out;
+}
+
+double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+std::atomic<bool> g_running{true};
+void handle_signal(int) { g_running.store(false); }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Args args;
+    if (!parse_args(argc, argv, args)) return 2;
+
+    if (args.rate_hz <= 0) {
+        std::cerr << "--rate-hz must be > 0\n";
+        return 2;
+    }
+    if (args.fanout == 0) {
+        std::cerr << "--fanout must be > 0\n";
+        return 2;
+    }
+    if (args.count == 0) {
+        std::cerr << "--count must be > 0\n";
+        return 2;
+    }
+    const std::vector<std::string> endpoints = bench::split_csv(args.connect);
+    if (endpoints.empty()) {
+        std::cerr << "--connect must name at least one endpoint\n";
+        return 2;
+    }
+    if (args.payload_bytes < sizeof(bench::ReqHeader)) {
+        std::cerr << "--payload-bytes must be >= " << sizeof(bench::ReqHeader) << "\n";
+        return 2;
+    }
+
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+
+    std::cout << "bench_keyspace connected=" << args.connect << " key_prefix=" << args.key_prefix
+              << " fanout=" << args.fanout << " rate_hz=" << args.rate_hz << " payload_bytes=" << args.payload_bytes
+              << " count=" << args.count << (args.single_session ? " single_session" : "") << "\n";
+
+    const auto old_flags = std::cout.flags();
+    const auto old_prec = std::cout.precision();
+    std::cout.setf(std::ios::fixed);
+    std::cout << std::setprecision(3);
+
+    try {
+        for (const std::uint64_t n_keys : args.keys) {
+            for (const std::uint64_t n_subs : args.subs) {
+                if (!g_running.load()) break;
+                using Clock = std::chrono::steady_clock;
+                const std::uint64_t groups = (n_keys + args.fanout - 1) / args.fanout;
+
+                std::mutex mu;
+                OnlineStats latency_us;
+                // Each message reaches every subscriber at most once. Past the cap
+                // only every `sample_stride`-th delivery is kept, so the callback
+                // never grows the vector under mu.
+                const std::uint64_t max_deliveries = args.count * n_subs;
+                const std::uint64_t sample_stride =
+                    std::max<std::uint64_t>(1, (max_deliveries + kMaxLatencySamples - 1) / kMaxLatencySamples);
+                std::vector<double> latency_samples;
+                latency_samples.reserve(static_cast<std::size_t>(std::min(max_deliveries, kMaxLatencySamples)));
+
+                // Setup phases.
+                auto t0 = Clock::now();
+                std::optional<Session> pub_session(bench::open_session(endpoints[0]));
+                const double open_pub_ms = ms_since(t0);
+                std::optional<Session> sub_session_storage;
+                double open_sub_ms = 0.0;
+                if (!args.single_session) {
+                    t0 = Clock::now();
+                    sub_session_storage.emplace(bench::open_session(endpoints[1 % endpoints.size()]));
+                    open_sub_ms = ms_since(t0);
+                }
+                Session& sub_session = args.single_session ? *pub_session : *sub_session_storage;
+
+                t0 = Clock::now();
+                std::vector<Subscriber<void>> subs;
+                subs.reserve(static_cast<std::size_t>(n_subs));
+                for (std::uint64_t i = 0; i < n_subs; ++i) {
+                    subs.push_back(sub_session.declare_subscriber(
+                        KeyExpr(subscriber_key(args, i, groups)),
+                        [&](const Sample& sample) {
+                            const std::uint64_t now_ns = steady_now_ns();
+                            std::string payload = sample.get_payload().as_string();
+                            bench::ReqHeader req{};
+                            if (!bench::parse_req_payload(payload.data(), payload.size(), req)) return;
+                            const double us = static_cast<double>(now_ns - req.client_send_mono_ns) / 1000.0;
+                            std::lock_guard<std::mutex> lk(mu);
+                            latency_us.add(us);
+                            if ((latency_us.n - 1) % sample_stride == 0 &&
+                                latency_samples.size() < latency_samples.capacity()) {
+                                latency_samples.push_back(us);
+                            }
+                        },
+                        closures::none));
+                }
+                const double decl_subs_ms = ms_since(t0);
+
+                t0 = Clock::now();
+                std::vector<Publisher> pubs;
+                pubs.reserve(static_cast<std::size_t>(n_keys));
+                for (std::uint64_t i = 0; i < n_keys; ++i) {
+                    pubs.push_back(pub_session->declare_publisher(KeyExpr(publisher_key(args, i))));
+                }
+                const double decl_pubs_ms = ms_since(t0);
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(args.settle_ms));
+
+                // Steady-state window: round-robin over the K publishers at --rate-hz.
+                bench::CostMeter cost;
+                cost.begin();
+                const auto start_tp = Clock::now();
+                const auto interval = std::chrono::nanoseconds(static_cast<std::int64_t>(1e9 / args.rate_hz));
+                auto next_send = start_tp;
+                std::uint64_t sent = 0;
+                while (sent < args.count && g_running.load()) {
+                    if (Clock::now() < next_send) std::this_thread::sleep_until(next_send);
+                    std::string payload = bench::make_req_payload(sent, steady_now_ns(), args.payload_bytes);
+                    pubs[static_cast<std::size_t>(sent % n_keys)].put(payload);
+                    ++sent;
+                    next_send += interval;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(args.drain_ms));
+                const double dur_s = std::chrono::duration<double>(Clock::now() - start_tp).count();
+                cost.end();
+
+                // Tear down before the next run so sessions and routes do not accumulate.
+                subs.clear();
+                pubs.clear();
+                sub_session_storage.reset();
+                pub_session.reset();
+
+                std::vector<double> sorted;
+                OnlineStats lat;
+                {
+                    std::lock_guard<std::mutex> lk(mu);
+                    sorted = latency_samples;
+                    lat = latency_us;
+                }
+                std::sort(sorted.begin(), sorted.end());
+
+                std::cout << "=== 汇总（Key 空间规模，K=" << n_keys << "，S=" << n_subs << "）===\n"
+                          << "订阅表达式示例: " << subscriber_key(args, 0, groups) << "（发布 key 示例: "
+                          << publisher_key(args, 0) << "，共 " << groups << " 组）\n"
+                          << "建立耗时（毫秒 ms）: 发布会话 open " << open_pub_ms;
+                if (!args.single_session) std::cout << "，订阅会话 open " << open_sub_ms;
+                std::cout << "，声明 " << n_subs << " 个订阅 " << decl_subs_ms << "（每个 "
+                          << (decl_subs_ms * 1000.0 / static_cast<double>(n_subs)) << " us），声明 " << n_keys
+                          << " 个发布 " << decl_pubs_ms << "（每个 "
+                          << (decl_pubs_ms * 1000.0 / static_cast<double>(n_keys)) << " us）\n"
+                          << "发送: " << sent << " 条，投递: " << lat.n << " 次（每条平均扇出 "
+                          << ((sent > 0) ? (static_cast<double>(lat.n) / static_cast<double>(sent)) : 0.0) << "）\n";
+                if (lat.n > 0) {
+                    std::cout << "单向延迟（微秒 us）: 平均 " << lat.mean << "，最小 " << lat.min_v << "，最大 " << lat.max_v
+                              << "，P50 " << percentile_sorted(sorted, 0.50) << "，P99 "
+                              << percentile_sorted(sorted, 0.99);
+                    if (sample_stride > 1) std::cout << "（分位数按每 " << sample_stride << " 次投递取 1 个样本）";
+                    std::cout << "\n";
+                } else {
+                    std::cout << "单向延迟: 无有效样本（检查 --sub-pattern 是否匹配发布 key）\n";
+                }
+                cost.print(std::cout, sent, dur_s, "发送线程");
+                // With S subscribers the work scales with deliveries, not messages sent.
+                const double cpu_us = static_cast<double>(cost.process().cpu_ns()) / 1000.0;
+                std::cout << "每次投递 CPU: " << ((lat.n > 0) ? (cpu_us / static_cast<double>(lat.n)) : 0.0)
+                          << " us（进程 CPU / 投递次数）\n";
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error in bench_keyspace: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout.flags(old_flags);
+    std::cout.precision(old_prec);
+    return 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Reads one non-negative number per line (service times, inter-arrival
+// gaps). Blank lines and lines whose first non-blank character is '#' are
+// skipped. Any other line that is not exactly one non-negative number fails
+// the whole file with "path:line: ...", so a typo can never turn into a 0.
+inline bool read_number_file(const std::string& path, std::vector<double>& out, std::string& err) {
+    std::ifstream in(path);
+    if (!in) {
+        err = "cannot open " + path;
+        return false;
+    }
+    std::vector<double> values;
+    std::string line;
+    std::size_t line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        const std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        const char* begin = line.c_str() + first;
+        char* end = nullptr;
+        const double v = std::strtod(begin, &end);
+        const bool trailing_ok =
+            line.find_first_not_of(" \t\r", static_cast<std::size_t>(end - line.c_str())) == std::string::npos;
+        if (end == begin || !trailing_ok || !(v >= 0.0)) {
+            err = path + ":" + std::to_string(line_no) + ": not a non-negative number: " + line;
+            return false;
+        }
+        values.push_back(v);
+    }
+    out.swap(values);
+    return true;
+}
+
+}  // namespace bench
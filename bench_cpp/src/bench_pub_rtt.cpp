@@ -1,4 +1,9 @@
+#include "bench_alloc.hpp"
+#include "bench_arrival.hpp"
+#include "bench_cost.hpp"
 #include "bench_protocol.hpp"
+#include "bench_recv.hpp"
+#include "bench_session.hpp"
 #include "zenoh.hxx"
 
 #include <algorithm>
@@ -49,6 +54,10 @@ struct Args {
     std::string req_key = bench::kDefaultReqKey;
     std::string ack_key = bench::kDefaultAckKey;
     int rate_hz = 1000;
+    bench::ArrivalProfile arrival = bench::ArrivalProfile::kFixed;
+    std::uint64_t burst_size = 10;
+    double burst_gap_us = 0.0;
+    std::string trace_file;
     std::size_t payload_bytes = bench::kPayloadBytes;  // default 1024
 
     // End condition:
@@ -56,6 +65,12 @@ struct Args {
     double duration_sec = 10.0;    // used if count==0
 
     int ack_timeout_ms = 100;
+    bench::RecvMode recv_mode = bench::RecvMode::kCallback;
+    std::size_t recv_queue = 1024;
+    int recv_cpu = -1;
+    int sessions = 1;
+    double warmup_sec = 0.0;         // excluded from steady-state stats
+    std::uint64_t warmup_count = 0;  // excluded from steady-state stats
     bool quiet = false;
 };
 
@@ -86,6 +101,25 @@ bool parse_args(int argc, char** argv, Args& out) {
             const char* v = need("--rate-hz");
             if (!v) return false;
             out.rate_hz = std::atoi(v);
+        } else if (a == "--arrival") {
+            const char* v = need("--arrival");
+            if (!v) return false;
+            if (!bench::parse_arrival_profile(v, out.arrival)) {
+                std::cerr << "Invalid --arrival: " << v << " (expected fixed|poisson|burst|trace)\n";
+                return false;
+            }
+        } else if (a == "--burst-size") {
+            const char* v = need("--burst-size");
+            if (!v) return false;
+            out.burst_size = static_cast<std::uint64_t>(std::strtoull(v, nullptr, 10));
+        } else if (a == "--burst-gap-us") {
+            const char* v = need("--burst-gap-us");
+            if (!v) return false;
+            out.burst_gap_us = std::atof(v);
+        } else if (a == "--trace-file") {
+            const char* v = need("--trace-file");
+            if (!v) return false;
+            out.trace_file = v;
         } else if (a == "--payload-bytes") {
             const char* v = need("--payload-bytes");
             if (!v) return false;
@@ -102,20 +136,58 @@ bool parse_args(int argc, char** argv, Args& out) {
             const char* v = need("--ack-timeout-ms");
             if (!v) return false;
             out.ack_timeout_ms = std::atoi(v);
+        } else if (a == "--recv-mode") {
+            const char* v = need("--recv-mode");
+            if (!v) return false;
+            if (!bench::parse_recv_mode(v, out.recv_mode)) {
+                std::cerr << "Invalid --recv-mode: " << v << " (expected callback|fifo|ring-spin)\n";
+                return false;
+            }
+        } else if (a == "--recv-queue") {
+            const char* v = need("--recv-queue");
+            if (!v) return false;
+            out.recv_queue = static_cast<std::size_t>(std::strtoull(v, nullptr, 10));
+        } else if (a == "--recv-cpu") {
+            const char* v = need("--recv-cpu");
+            if (!v) return false;
+            out.recv_cpu = std::atoi(v);
+        } else if (a == "--sessions") {
+            const char* v = need("--sessions");
+            if (!v) return false;
+            out.sessions = std::atoi(v);
+        } else if (a == "--warmup-sec") {
+            const char* v = need("--warmup-sec");
+            if (!v) return false;
+            out.warmup_sec = std::atof(v);
+        } else if (a == "--warmup-count") {
+            const char* v = need("--warmup-count");
+            if (!v) return false;
+            out.warmup_count = static_cast<std::uint64_t>(std::strtoull(v, nullptr, 10));
         } else if (a == "--quiet") {
             out.quiet = true;
         } else if (a == "-h" || a == "--help") {
             std::cout
                 << "bench_pub_rtt\n\n"
-                << "  --connect         <endpoint>  (default: tcp/127.0.0.1:7447)\n"
+                << "  --connect         <endpoint>  (default: tcp/127.0.0.1:7447; comma-separated list is\n"
+                << "                                 assigned to sessions round-robin)\n"
                 << "  --req-key         <keyexpr>   (default: " << bench::kDefaultReqKey << ")\n"
                 << "  --ack-key         <keyexpr>   (default: " << bench::kDefaultAckKey << ")\n"
                 << "  --rate-hz         <int>       (default: 1000)\n"
+                << "  --arrival         <profile>   (fixed|poisson|burst|trace, default: fixed)\n"
+                << "  --burst-size      <uint64>    (messages per burst, default: 10)\n"
+                << "  --burst-gap-us    <double>    (spacing inside a burst, default: 0)\n"
+                << "  --trace-file      <path>      (inter-arrival times in us, one per line)\n"
                 << "  --payload-bytes   <int>       (default: " << bench::kPayloadBytes
                 << ", must be >= " << sizeof(bench::ReqHeader) << ")\n"
                 << "  --count           <uint64>    (if set, ignore --duration-sec)\n"
                 << "  --duration-sec    <double>    (default: 10.0)\n"
                 << "  --ack-timeout-ms  <int>       (default: 100)\n"
+                << "  --recv-mode       <mode>      (callback|fifo|ring-spin, default: callback)\n"
+                << "  --recv-queue      <int>       (fifo/ring capacity, default: 1024)\n"
+                << "  --recv-cpu        <int>       (pin ACK drain thread to this CPU, default: none)\n"
+                << "  --sessions        <int>       (sessions to stripe messages across, default: 1)\n"
+                << "  --warmup-sec      <double>    (exclude the first seconds from stats, default: 0)\n"
+                << "  --warmup-count    <uint64>    (exclude the first messages from stats, default: 0)\n"
                 << "  --quiet                      (reduce logs)\n";
             std::exit(0);
         } else {
@@ -148,6 +220,7 @@ void handle_signal(int) { g_running.store(false); }
 }  // namespace
 
 int main(int argc, char** argv) {
+    const auto process_start_tp = std::chrono::steady_clock::now();
     Args args;
     if (!parse_args(argc, argv, args)) return 2;
 
@@ -159,20 +232,65 @@ int main(int argc, char** argv) {
         std::cerr << "--payload-bytes must be >= " << sizeof(bench::ReqHeader) << "\n";
         return 2;
     }
+    const std::vector<std::string> endpoints = bench::split_csv(args.connect);
+    if (endpoints.empty()) {
+        std::cerr << "--connect must name at least one endpoint\n";
+        return 2;
+    }
+    if (args.sessions <= 0) {
+        std::cerr << "--sessions must be > 0\n";
+        return 2;
+    }
+    if (args.burst_size == 0) {
+        std::cerr << "--burst-size must be > 0\n";
+        return 2;
+    }
+    if (args.burst_gap_us < 0.0) {
+        std::cerr << "--burst-gap-us must be >= 0\n";
+        return 2;
+    }
+    if (args.arrival == bench::ArrivalProfile::kBurst &&
+        args.burst_gap_us * 1e-6 * static_cast<double>(args.burst_size - 1) >
+            static_cast<double>(args.burst_size) / static_cast<double>(args.rate_hz)) {
+        std::cerr << "--burst-gap-us too large: a burst of " << args.burst_size << " would take longer than "
+                  << args.burst_size << " messages at --rate-hz " << args.rate_hz << "\n";
+        return 2;
+    }
+    bench::ArrivalProcess arrival(args.arrival, args.rate_hz, args.burst_size, args.burst_gap_us);
+    if (args.arrival == bench::ArrivalProfile::kTrace) {
+        std::string err;
+        if (!arrival.load_trace(args.trace_file, err)) {
+            std::cerr << "--trace-file: " << err << "\n";
+            return 2;
+        }
+    }
 
     std::signal(SIGINT, handle_signal);
     std::signal(SIGTERM, handle_signal);
+    bench::alloc::set_thread_role(bench::alloc::ThreadRole::kSender);
 
     try {
-        Config config = Config::create_default();
-        const std::string endpoints_json = "[\"" + args.connect + "\"]";
-        config.insert_json5("connect/endpoints", endpoints_json);
-        auto session = Session::open(std::move(config));
-
-        auto req_pub = session.declare_publisher(KeyExpr(args.req_key));
-
         using Clock = std::chrono::steady_clock;
         using TP = Clock::time_point;
+        auto ms_between = [](TP a, TP b) { return std::chrono::duration<double, std::milli>(b - a).count(); };
+
+        // Messages are striped round-robin: seq goes out on session seq % N.
+        const std::size_t n_sessions = static_cast<std::size_t>(args.sessions);
+        std::vector<Session> sessions;
+        std::vector<Publisher> req_pubs;
+        sessions.reserve(n_sessions);
+        req_pubs.reserve(n_sessions);
+        double open_ms = 0.0;
+        double declare_pub_ms = 0.0;
+        for (std::size_t i = 0; i < n_sessions; ++i) {
+            const auto t0 = Clock::now();
+            sessions.push_back(bench::open_session(endpoints[i % endpoints.size()]));
+            const auto t1 = Clock::now();
+            req_pubs.push_back(
+                sessions.back().declare_publisher(KeyExpr(bench::session_key(args.req_key, i, n_sessions))));
+            open_ms += ms_between(t0, t1);
+            declare_pub_ms += ms_between(t1, Clock::now());
+        }
 
         std::mutex mu;
         std::vector<TP> send_ts;          // indexed by seq when count mode
@@ -184,8 +302,35 @@ int main(int argc, char** argv) {
         std::uint64_t ack_received = 0;
         std::uint64_t timeouts = 0;
         std::uint64_t out_of_order = 0;
-        std::uint64_t last_ack_seq = 0;
-        bool have_last_ack_seq = false;
+        std::vector<std::uint64_t> last_ack_seq(n_sessions, 0);
+        std::vector<bool> have_last_ack_seq(n_sessions, false);
+
+        struct SessionStats {
+            std::uint64_t sent = 0;
+            std::uint64_t acked = 0;
+            std::uint64_t timeouts = 0;
+            OnlineStats rtt_us;
+        };
+        std::vector<SessionStats> per_session(n_sessions);
+
+        // Requests with seq < steady_seq0 belong to the warm-up window. It stays
+        // at max until the sender leaves warm-up.
+        const bool has_warmup = args.warmup_sec > 0.0 || args.warmup_count > 0;
+        std::uint64_t steady_seq0 = has_warmup ? std::numeric_limits<std::uint64_t>::max() : 0;
+        std::uint64_t warmup_acked = 0;
+        std::uint64_t warmup_timeouts = 0;
+        bool have_first_ack = false;
+        TP first_ack_tp{};
+        TP first_acked_send_tp{};
+
+        auto count_timeout = [&](std::uint64_t s) {
+            if (s < steady_seq0) {
+                ++warmup_timeouts;
+                return;
+            }
+            ++timeouts;
+            ++per_session[static_cast<std::size_t>(s % n_sessions)].timeouts;
+        };
 
         const auto timeout = std::chrono::milliseconds(args.ack_timeout_ms);
 
@@ -194,23 +339,36 @@ int main(int argc, char** argv) {
             state.resize(static_cast<std::size_t>(args.count), 0);
             rtt_us_samples.reserve(static_cast<std::size_t>(args.count));
         } else {
-            rtt_us_samples.reserve(static_cast<std::size_t>(args.rate_hz * args.duration_sec * 1.2));
-            send_map.reserve(static_cast<std::size_t>(args.rate_hz * 2));
+            // Size from the profile's real rate (a trace may run faster than
+            // --rate-hz) so the ACK handler never reallocates under mu.
+            const double rate = arrival.mean_rate_hz();
+            rtt_us_samples.reserve(static_cast<std::size_t>(rate * args.duration_sec * 1.2) + args.burst_size);
+            send_map.reserve(static_cast<std::size_t>(rate * 2) + args.burst_size);
         }
 
-        auto ack_sub = session.declare_subscriber(
-            KeyExpr(args.ack_key),
-            [&](const Sample& sample) {
+        bench::SampleReceiver receiver(
+            args.recv_mode, args.recv_queue, args.recv_cpu,
+            [&](const bench::RecvSample& rs) {
                 const auto now_tp = Clock::now();
-                std::string payload = sample.get_payload().as_string();
                 bench::AckHeader ack{};
-                if (!bench::parse_ack_payload(payload.data(), payload.size(), ack)) return;
+                if (!bench::parse_ack_payload(rs.head, rs.head_len, ack)) return;
 
                 std::lock_guard<std::mutex> lk(mu);
+                SessionStats& ss = per_session[rs.tag];
 
-                if (have_last_ack_seq && ack.seq <= last_ack_seq) ++out_of_order;
-                last_ack_seq = ack.seq;
-                have_last_ack_seq = true;
+                const bool warm = ack.seq < steady_seq0;
+                if (!warm) {
+                    if (have_last_ack_seq[rs.tag] && ack.seq <= last_ack_seq[rs.tag]) ++out_of_order;
+                    last_ack_seq[rs.tag] = ack.seq;
+                    have_last_ack_seq[rs.tag] = true;
+                }
+
+                auto note_ack = [&](TP sent_tp) {
+                    if (have_first_ack) return;
+                    have_first_ack = true;
+                    first_ack_tp = now_tp;
+                    first_acked_send_tp = sent_tp;
+                };
 
                 if (args.count > 0) {
                     if (ack.seq >= args.count) return;
@@ -218,7 +376,14 @@ int main(int argc, char** argv) {
                     const auto sent_tp = send_ts[static_cast<std::size_t>(ack.seq)];
                     const auto rtt = std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(now_tp - sent_tp);
                     state[static_cast<std::size_t>(ack.seq)] = 2;
+                    note_ack(sent_tp);
+                    if (warm) {
+                        ++warmup_acked;
+                        return;
+                    }
                     ++ack_received;
+                    ++ss.acked;
+                    ss.rtt_us.add(rtt.count());
                     rtt_us_stats.add(rtt.count());
                     rtt_us_samples.push_back(rtt.count());
                 } else {
@@ -226,26 +391,70 @@ int main(int argc, char** argv) {
                     if (it == send_map.end()) return;
                     const auto rtt =
                         std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(now_tp - it->second);
+                    note_ack(it->second);
                     send_map.erase(it);
+                    if (warm) {
+                        ++warmup_acked;
+                        return;
+                    }
                     ++ack_received;
+                    ++ss.acked;
+                    ss.rtt_us.add(rtt.count());
                     rtt_us_stats.add(rtt.count());
                     rtt_us_samples.push_back(rtt.count());
                 }
-            },
-            closures::none);
-
-        (void)ack_sub;
+            });
+        receiver.start();
+
+        const auto declare_sub_t0 = Clock::now();
+        std::vector<Subscriber<void>> ack_subs;
+        ack_subs.reserve(n_sessions);
+        for (std::size_t i = 0; i < n_sessions; ++i) {
+            const auto tag = static_cast<std::uint32_t>(i);
+            ack_subs.push_back(sessions[i].declare_subscriber(
+                KeyExpr(bench::session_key(args.ack_key, i, n_sessions)),
+                [&receiver, tag](const Sample& sample) {
+                    bench::alloc::set_thread_role(bench::alloc::ThreadRole::kReceive);
+                    std::string payload = sample.get_payload().as_string();
+                    receiver.offer(payload.data(), payload.size(), tag);
+                },
+                closures::none));
+        }
+        const auto decl_done_tp = Clock::now();
+        const double declare_sub_ms = ms_between(declare_sub_t0, decl_done_tp);
 
         std::cout << "bench_pub_rtt connected=" << args.connect << " req_key=" << args.req_key
                   << " ack_key=" << args.ack_key << " rate_hz=" << args.rate_hz
+                  << " arrival=" << bench::arrival_profile_name(args.arrival)
                   << " payload_bytes=" << args.payload_bytes
                   << ((args.count > 0) ? (" count=" + std::to_string(args.count))
                                        : (" duration_sec=" + std::to_string(args.duration_sec)))
-                  << " ack_timeout_ms=" << args.ack_timeout_ms << "\n";
-
+                  << " ack_timeout_ms=" << args.ack_timeout_ms
+                  << " recv_mode=" << bench::recv_mode_name(args.recv_mode) << " sessions=" << n_sessions
+                  << " warmup_sec=" << args.warmup_sec << " warmup_count=" << args.warmup_count << "\n";
+
+        bench::CostMeter cost;
+        bench::alloc::Snapshot alloc_start{};
+        TP steady_start_tp{};
+        bool steady = false;
+        // Starts the steady-state window at request `seq`. CostMeter::begin()
+        // opens perf counters on every thread, so callers run this before the
+        // intended send time of `seq` is fixed, never between that time and put().
+        auto enter_steady = [&](std::uint64_t seq) {
+            steady = true;
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                steady_seq0 = seq;
+            }
+            receiver.reset_stats();
+            cost.begin();
+            alloc_start = bench::alloc::snapshot();
+            steady_start_tp = Clock::now();
+        };
+        if (!has_warmup) enter_steady(0);
         const auto start_tp = Clock::now();
-        const auto interval = std::chrono::microseconds(static_cast<int>(1000000 / args.rate_hz));
         auto next_send = start_tp;
+        OnlineStats send_lag_us{};
 
         std::uint64_t sent = 0;
         auto should_continue = [&]() -> bool {
@@ -258,28 +467,46 @@ int main(int argc, char** argv) {
         };
 
         while (should_continue()) {
+            if (!steady && sent >= args.warmup_count &&
+                std::chrono::duration<double>(next_send - start_tp).count() >= args.warmup_sec) {
+                enter_steady(sent);
+                // Keep the meter setup out of the first steady request's RTT.
+                const auto ready_tp = Clock::now();
+                if (next_send < ready_tp) next_send = ready_tp;
+            }
+
             const auto now_tp = Clock::now();
             if (now_tp < next_send) {
                 std::this_thread::sleep_until(next_send);
             }
 
-            const auto send_tp = Clock::now();
+            // RTT and timeouts are measured from the intended send time, so a
+            // stalled sender cannot hide queueing (no coordinated omission).
+            const auto send_tp = next_send;
             const std::uint64_t send_ns = steady_now_ns();
             const std::uint64_t seq = sent++;
+            const std::size_t si = static_cast<std::size_t>(seq % n_sessions);
+            if (steady) {
+                send_lag_us.add(std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+                                    Clock::now() - send_tp)
+                                    .count());
+            }
 
             if (args.count > 0) {
                 std::lock_guard<std::mutex> lk(mu);
                 send_ts[static_cast<std::size_t>(seq)] = send_tp;
                 state[static_cast<std::size_t>(seq)] = 1;
                 inflight.push_back(seq);
+                if (steady) ++per_session[si].sent;
             } else {
                 std::lock_guard<std::mutex> lk(mu);
                 send_map.emplace(seq, send_tp);
                 inflight.push_back(seq);
+                if (steady) ++per_session[si].sent;
             }
 
             std::string payload = bench::make_req_payload(seq, send_ns, args.payload_bytes);
-            req_pub.put(payload);
+            req_pubs[si].put(payload);
 
             if (!args.quiet && (seq % 1000 == 0)) {
                 std::size_t inflight_sz = 0;
@@ -305,7 +532,7 @@ int main(int argc, char** argv) {
                         const auto age = now2 - send_ts[static_cast<std::size_t>(s)];
                         if (age > timeout) {
                             state[static_cast<std::size_t>(s)] = 3;
-                            ++timeouts;
+                            count_timeout(s);
                             inflight.pop_front();
                             continue;
                         }
@@ -319,7 +546,7 @@ int main(int argc, char** argv) {
                         const auto age = now2 - it->second;
                         if (age > timeout) {
                             send_map.erase(it);
-                            ++timeouts;
+                            count_timeout(s);
                             inflight.pop_front();
                             continue;
                         }
@@ -328,7 +555,7 @@ int main(int argc, char** argv) {
                 }
             }
 
-            next_send += interval;
+            next_send += arrival.next_gap();
         }
 
         // Drain remaining inflight until timeout threshold reached.
@@ -349,7 +576,7 @@ int main(int argc, char** argv) {
                             const auto age = now_tp - send_ts[static_cast<std::size_t>(s)];
                             if (age > timeout) {
                                 state[static_cast<std::size_t>(s)] = 3;
-                                ++timeouts;
+                                count_timeout(s);
                                 inflight.pop_front();
                                 continue;
                             }
@@ -363,7 +590,7 @@ int main(int argc, char** argv) {
                             const auto age = now_tp - it->second;
                             if (age > timeout) {
                                 send_map.erase(it);
-                                ++timeouts;
+                                count_timeout(s);
                                 inflight.pop_front();
                                 continue;
                             }
@@ -376,16 +603,23 @@ int main(int argc, char** argv) {
             }
         }
 
+        receiver.stop();
+        if (!steady) enter_steady(sent);
         const auto end_tp = Clock::now();
+        cost.end();
+        const auto alloc_delta = bench::alloc::snapshot() - alloc_start;
+        // Rates and ratios cover the steady-state window only.
+        const std::uint64_t warmup_sent = steady_seq0;
+        const std::uint64_t steady_sent = sent - warmup_sent;
         const double dur_s =
-            std::chrono::duration_cast<std::chrono::duration<double>>(end_tp - start_tp).count();
-        const double sent_per_s = (dur_s > 0.0) ? (static_cast<double>(sent) / dur_s) : 0.0;
+            std::chrono::duration_cast<std::chrono::duration<double>>(end_tp - steady_start_tp).count();
+        const double sent_per_s = (dur_s > 0.0) ? (static_cast<double>(steady_sent) / dur_s) : 0.0;
         const double ack_per_s = (dur_s > 0.0) ? (static_cast<double>(ack_received) / dur_s) : 0.0;
         const double mb_per_s =
-            (dur_s > 0.0) ? ((static_cast<double>(sent) * args.payload_bytes) / dur_s / 1024.0 / 1024.0)
+            (dur_s > 0.0) ? ((static_cast<double>(steady_sent) * args.payload_bytes) / dur_s / 1024.0 / 1024.0)
                           : 0.0;
         const double timeout_ratio_sent =
-            (sent > 0) ? (static_cast<double>(timeouts) / static_cast<double>(sent) * 100.0) : 0.0;
+            (steady_sent > 0) ? (static_cast<double>(timeouts) / static_cast<double>(steady_sent) * 100.0) : 0.0;
         const double out_of_order_ratio =
             (ack_received > 0)
                 ? (static_cast<double>(out_of_order) / static_cast<double>(ack_received) * 100.0)
@@ -417,7 +651,7 @@ int main(int argc, char** argv) {
 
         std::cout << "=== 汇总（RTT 往返时延测试）===\n"
                   << "运行时长: " << dur_s << " 秒\n"
-                  << "发送请求: " << sent << " 条\n"
+                  << "发送请求: " << steady_sent << " 条\n"
                   << "收到 ACK: " << ack_received << " 条\n"
                   << "超时次数: " << timeouts << " 条（占已发送 " << timeout_ratio_sent << " %）\n"
                   << "乱序 ACK: " << out_of_order << " 条（占已收到 ACK " << out_of_order_ratio << " %）\n"
@@ -435,6 +669,72 @@ int main(int argc, char** argv) {
             std::cout << "RTT: 无有效样本\n";
         }
 
+        if (n_sessions > 1) {
+            std::lock_guard<std::mutex> lk(mu);
+            for (std::size_t i = 0; i < n_sessions; ++i) {
+                const SessionStats& ss = per_session[i];
+                std::cout << "会话 " << i << "（" << endpoints[i % endpoints.size()] << "）: 发送 " << ss.sent
+                          << " 条，ACK " << ss.acked << " 条，超时 " << ss.timeouts << " 条，ACK 速率 "
+                          << ((dur_s > 0.0) ? (static_cast<double>(ss.acked) / dur_s) : 0.0) << " 条/秒";
+                if (ss.rtt_us.n > 0) {
+                    std::cout << "，RTT 平均 " << ss.rtt_us.mean << " us，最大 " << ss.rtt_us.max_v << " us";
+                }
+                std::cout << "\n";
+            }
+        }
+
+        std::cout << "到达模型: " << bench::arrival_profile_name(args.arrival) << "（平均 " << arrival.mean_rate_hz()
+                  << " 条/秒";
+        if (args.arrival == bench::ArrivalProfile::kBurst) {
+            std::cout << "，每簇 " << args.burst_size << " 条，簇内间隔 " << args.burst_gap_us << " us";
+        } else if (args.arrival == bench::ArrivalProfile::kTrace) {
+            std::cout << "，轨迹 " << arrival.trace_size() << " 个间隔";
+        }
+        std::cout << "）\n";
+        if (send_lag_us.n > 0) {
+            std::cout << "发送滞后（实际发送 - 计划时刻，微秒 us）: 平均 " << send_lag_us.mean << "，最大 "
+                      << send_lag_us.max_v << "\n";
+        }
+
+        std::cout << "启动耗时（毫秒 ms）: 进程启动到声明完成 " << ms_between(process_start_tp, decl_done_tp)
+                  << "，打开会话 " << open_ms << "，声明发布者 " << declare_pub_ms << "，声明订阅者 " << declare_sub_ms
+                  << "\n"
+                  << "发送端准备（声明完成到首次计划发送，含输出与计数器初始化，毫秒 ms）: "
+                  << ms_between(decl_done_tp, start_tp) << "\n";
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            if (have_first_ack) {
+                // Route discovery: requests sent before the echo side's subscriber
+                // was reachable never come back, so the first ACKed request marks
+                // when the path became usable. Both figures start at the first
+                // intended send so the sender's own setup is not counted.
+                std::cout << "首个 ACK（毫秒 ms）: 距首次计划发送 " << ms_between(start_tp, first_ack_tp)
+                          << "，距进程启动 " << ms_between(process_start_tp, first_ack_tp) << "\n"
+                          << "路由发现（首次计划发送到首个被 ACK 请求的发送时刻，毫秒 ms）: "
+                          << ms_between(start_tp, first_acked_send_tp) << "\n";
+            } else {
+                std::cout << "首个 ACK: 未收到\n";
+            }
+            if (has_warmup) {
+                std::cout << "预热（不计入统计）: 发送 " << warmup_sent << " 条，ACK " << warmup_acked << " 条，超时 "
+                          << warmup_timeouts << " 条\n";
+            }
+        }
+
+        std::cout << "接收模式: " << bench::recv_mode_name(args.recv_mode) << "\n";
+        cost.print(std::cout, steady_sent, dur_s, "发送线程");
+        bench::alloc::print_summary(std::cout, alloc_delta, steady_sent);
+        if (args.recv_mode != bench::RecvMode::kCallback) {
+            bench::print_thread_usage(
+                std::cout,
+                receiver.pinned() ? "接收线程（已绑核 " + std::to_string(args.recv_cpu) + "）" : "接收线程",
+                receiver.drain_usage());
+            std::cout << "队列交接延迟（微秒 us）: 平均 " << receiver.handoff_avg_us() << "，最大 "
+                      << receiver.handoff_max_us() << "\n"
+                      << "最大队列深度: " << receiver.max_depth() << " 条\n"
+                      << "队列丢弃: " << receiver.dropped() << " 条\n";
+        }
+
         std::cout.flags(old_flags);
         std::cout.precision(old_prec);
     } catch (const std::exception& e) {
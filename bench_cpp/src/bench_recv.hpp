@@ -0,0 +1,420 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_alloc.hpp"
+#include "bench_cost.hpp"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace bench {
+
+// How received samples reach the benchmark logic:
+//   callback  - handled directly on zenoh's callback thread (original behavior)
+//   fifo      - callback copies into a bounded FIFO, a dedicated thread blocks on it
+//   ring-spin - callback copies into a bounded ring, a dedicated thread busy-polls it
+enum class RecvMode { kCallback, kFifo, kRingSpin };
+
+inline const char* recv_mode_name(RecvMode m) {
+    switch (m) {
+        case RecvMode::kCallback: return "callback";
+        case RecvMode::kFifo: return "fifo";
+        case RecvMode::kRingSpin: return "ring-spin";
+    }
+    return "?";
+}
+
+inline bool parse_recv_mode(const std::string& s, RecvMode& out) {
+    if (s == "callback") {
+        out = RecvMode::kCallback;
+    } else if (s == "fifo") {
+        out = RecvMode::kFifo;
+    } else if (s == "ring-spin" || s == "ring") {
+        out = RecvMode::kRingSpin;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline std::uint64_t mono_now_ns() {
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+inline std::uint64_t timespec_ns(const timespec& ts) {
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+// CPU time consumed by the calling thread.
+inline std::uint64_t thread_cpu_ns() {
+    timespec ts{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+    return timespec_ns(ts);
+}
+
+// Pin the calling thread to one CPU. Returns false if unsupported or refused.
+inline bool pin_current_thread(int cpu) {
+#if defined(__linux__)
+    if (cpu < 0) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// Fixed-size copy of the part of a sample the benchmarks look at. Only the
+// protocol header is kept, so queueing a sample never allocates.
+struct RecvItem {
+    static constexpr std::size_t kHeadBytes = 32;
+
+    std::uint64_t enqueue_ns = 0;
+    std::size_t payload_len = 0;
+    std::size_t head_len = 0;
+    std::uint32_t tag = 0;
+    std::array<std::uint8_t, kHeadBytes> head{};
+
+    void assign(const void* data, std::size_t len, std::uint32_t t, std::uint64_t arrival_ns) {
+        enqueue_ns = arrival_ns;
+        payload_len = len;
+        tag = t;
+        head_len = (len < kHeadBytes) ? len : kHeadBytes;
+        std::memcpy(head.data(), data, head_len);
+    }
+};
+
+// Bounded FIFO: producer blocks when full (like zenoh's FifoChannel), the
+// consumer blocks when empty.
+class FifoQueue {
+   public:
+    explicit FifoQueue(std::size_t capacity) : buf_(capacity ? capacity : 1) {}
+
+    // `arrival_ns` is taken by the caller before push() can block, so time
+    // spent waiting for room still shows up as queueing delay.
+    bool push(const void* data, std::size_t len, std::uint32_t tag, std::uint64_t arrival_ns) {
+        std::unique_lock<std::mutex> lk(mu_);
+        not_full_.wait(lk, [&] { return closed_ || size_ < buf_.size(); });
+        if (closed_) return false;
+        buf_[(head_ + size_) % buf_.size()].assign(data, len, tag, arrival_ns);
+        ++size_;
+        if (size_ > max_depth_) max_depth_ = size_;
+        lk.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    bool pop(RecvItem& out) {
+        std::unique_lock<std::mutex> lk(mu_);
+        not_empty_.wait(lk, [&] { return closed_ || size_ > 0; });
+        if (size_ == 0) return false;
+        out = buf_[head_];
+        head_ = (head_ + 1) % buf_.size();
+        --size_;
+        lk.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    std::size_t max_depth() {
+        std::lock_guard<std::mutex> lk(mu_);
+        return max_depth_;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            closed_ = true;
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+   private:
+    std::mutex mu_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::vector<RecvItem> buf_;
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+    std::size_t max_depth_ = 0;
+    bool closed_ = false;
+};
+
+// Bounded lock-free ring (Vyukov MPMC). Producers never block: when the ring is
+// full the sample is dropped and counted, the consumer polls with try_pop().
+class RingQueue {
+   public:
+    explicit RingQueue(std::size_t capacity) {
+        std::size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        mask_ = cap - 1;
+        cells_ = std::vector<Cell>(cap);
+        for (std::size_t i = 0; i < cap; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool try_push(const void* data, std::size_t len, std::uint32_t tag, std::uint64_t arrival_ns) {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells_[pos & mask_];
+            const std::size_t seq = c.seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.item.assign(data, len, tag, arrival_ns);
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    note_depth(pos + 1 - dequeue_pos_.load(std::memory_order_relaxed));
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(RecvItem& out) {
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells_[pos & mask_];
+            const std::size_t seq = c.seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = c.item;
+                    c.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // empty
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::size_t max_depth() const { return max_depth_.load(std::memory_order_relaxed); }
+
+   private:
+    void note_depth(std::size_t depth) {
+        std::size_t cur = max_depth_.load(std::memory_order_relaxed);
+        while (depth > cur && depth <= mask_ + 1 &&
+               !max_depth_.compare_exchange_weak(cur, depth, std::memory_order_relaxed)) {
+        }
+    }
+
+    struct Cell {
+        std::atomic<std::size_t> seq{0};
+        RecvItem item;
+
+        Cell() = default;
+        Cell(Cell&& o) noexcept : seq(o.seq.load(std::memory_order_relaxed)), item(o.item) {}
+        Cell& operator=(Cell&& o) noexcept {
+            seq.store(o.seq.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            item = o.item;
+            return *this;
+        }
+    };
+
+    std::vector<Cell> cells_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<std::size_t> dequeue_pos_{0};
+    std::atomic<std::size_t> max_depth_{0};
+};
+
+// What the benchmark handler sees for each sample.
+struct RecvSample {
+    const std::uint8_t* head;  // leading payload bytes (at least the protocol header)
+    std::size_t head_len;
+    std::size_t payload_len;   // full payload length
+    std::uint64_t arrival_ns;  // mono ns, taken in offer() before any queueing
+    std::uint32_t tag;         // caller-defined, e.g. the session index
+};
+
+// Routes raw sample bytes from the zenoh callback to the benchmark handler
+// according to RecvMode. In the queued modes the handler runs on one of
+// `workers` drain threads, which also bounds how many samples are handled
+// concurrently.
+class SampleReceiver {
+   public:
+    using Handler = std::function<void(const RecvSample&)>;
+
+    SampleReceiver(RecvMode mode, std::size_t capacity, int cpu, Handler handler, int workers = 1)
+        : mode_(mode),
+          cpu_(cpu),
+          workers_(workers > 0 ? workers : 1),
+          handler_(std::move(handler)),
+          fifo_(capacity),
+          ring_(capacity) {}
+
+    ~SampleReceiver() { stop(); }
+
+    SampleReceiver(const SampleReceiver&) = delete;
+    SampleReceiver& operator=(const SampleReceiver&) = delete;
+
+    void start() {
+        if (mode_ == RecvMode::kCallback || !threads_.empty()) return;
+        running_.store(true);
+        for (int i = 0; i < workers_; ++i) {
+            threads_.emplace_back([this, i] { drain(i); });
+        }
+    }
+
+    void stop() {
+        if (threads_.empty()) return;
+        running_.store(false);
+        fifo_.close();
+        for (auto& t : threads_) t.join();
+        threads_.clear();
+    }
+
+    // Called from the zenoh subscriber callback.
+    void offer(const void* data, std::size_t len, std::uint32_t tag = 0) {
+        const std::uint64_t arrival_ns = mono_now_ns();
+        switch (mode_) {
+            case RecvMode::kCallback:
+                handler_(RecvSample{static_cast<const std::uint8_t*>(data), len, len, arrival_ns, tag});
+                break;
+            case RecvMode::kFifo:
+                fifo_.push(data, len, tag, arrival_ns);
+                break;
+            case RecvMode::kRingSpin:
+                if (!ring_.try_push(data, len, tag, arrival_ns)) dropped_.fetch_add(1, std::memory_order_relaxed);
+                break;
+        }
+    }
+
+    // Restarts the drain-thread figures (CPU, rusage, handoff latency), e.g.
+    // at the end of a warm-up. Each drain thread applies it before its next
+    // sample, or when it exits.
+    void reset_stats() { epoch_.fetch_add(1, std::memory_order_relaxed); }
+
+    RecvMode mode() const { return mode_; }
+    int workers() const { return workers_; }
+    bool pinned() const { return pinned_.load(); }
+    std::uint64_t dropped() const { return dropped_.load(); }
+    std::size_t max_depth() {
+        if (mode_ == RecvMode::kFifo) return fifo_.max_depth();
+        if (mode_ == RecvMode::kRingSpin) return ring_.max_depth();
+        return 0;
+    }
+
+    // Drain-thread figures, summed over workers; valid after stop().
+    std::uint64_t drain_cpu_ns() const { return totals_.cpu_ns; }
+    const CpuUsage& drain_usage() const { return totals_.usage; }
+    std::uint64_t handoff_count() const { return totals_.n; }
+    double handoff_avg_us() const {
+        return totals_.n ? (static_cast<double>(totals_.sum_ns) / static_cast<double>(totals_.n) / 1000.0) : 0.0;
+    }
+    double handoff_max_us() const { return static_cast<double>(totals_.max_ns) / 1000.0; }
+
+   private:
+    struct DrainStats {
+        std::uint64_t epoch = 0;
+        std::uint64_t cpu0_ns = 0;
+        CpuUsage usage0;
+        std::uint64_t cpu_ns = 0;
+        CpuUsage usage;
+        std::uint64_t n = 0;
+        std::uint64_t sum_ns = 0;
+        std::uint64_t max_ns = 0;
+    };
+
+    // Rebaselines `st` if reset_stats() was called since it was last checked.
+    void sync_epoch(DrainStats& st) {
+        const std::uint64_t e = epoch_.load(std::memory_order_relaxed);
+        if (e == st.epoch) return;
+        st = DrainStats{};
+        st.epoch = e;
+        st.cpu0_ns = thread_cpu_ns();
+        st.usage0 = thread_usage();
+    }
+
+    void consume(const RecvItem& item, DrainStats& st) {
+        sync_epoch(st);
+        const std::uint64_t now_ns = mono_now_ns();
+        const std::uint64_t d = (now_ns > item.enqueue_ns) ? (now_ns - item.enqueue_ns) : 0;
+        ++st.n;
+        st.sum_ns += d;
+        if (d > st.max_ns) st.max_ns = d;
+        handler_(RecvSample{item.head.data(), item.head_len, item.payload_len, item.enqueue_ns, item.tag});
+    }
+
+    void drain(int index) {
+        alloc::set_thread_role(alloc::ThreadRole::kReceive);
+        if (cpu_ >= 0 && pin_current_thread(cpu_ + index)) pinned_.store(true);
+        DrainStats st;
+        st.epoch = epoch_.load(std::memory_order_relaxed);
+        st.cpu0_ns = thread_cpu_ns();
+        st.usage0 = thread_usage();
+        RecvItem item;
+        if (mode_ == RecvMode::kFifo) {
+            while (fifo_.pop(item)) consume(item, st);
+        } else {
+            for (;;) {
+                if (ring_.try_pop(item)) {
+                    consume(item, st);
+                } else if (!running_.load(std::memory_order_relaxed)) {
+                    break;
+                } else {
+                    cpu_relax();
+                }
+            }
+        }
+        sync_epoch(st);
+        st.cpu_ns = thread_cpu_ns() - st.cpu0_ns;
+        st.usage = thread_usage() - st.usage0;
+
+        std::lock_guard<std::mutex> lk(totals_mu_);
+        totals_.cpu_ns += st.cpu_ns;
+        totals_.usage += st.usage;
+        totals_.n += st.n;
+        totals_.sum_ns += st.sum_ns;
+        if (st.max_ns > totals_.max_ns) totals_.max_ns = st.max_ns;
+    }
+
+    RecvMode mode_;
+    int cpu_;
+    int workers_;
+    Handler handler_;
+    FifoQueue fifo_;
+    RingQueue ring_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> pinned_{false};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<std::uint64_t> epoch_{0};
+
+    std::mutex totals_mu_;
+    DrainStats totals_;
+};
+
+}  // namespace bench
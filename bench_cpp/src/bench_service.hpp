@@ -0,0 +1,159 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_numfile.hpp"
+
+namespace bench {
+
+// Emulated per-message service time for the echo server.
+//   none      - reply immediately (original behavior)
+//   fixed     - every message takes exactly `mean_us`
+//   exp       - exponential with mean `mean_us`
+//   empirical - resampled uniformly from a file of service times (us, one per line)
+enum class ServiceDist { kNone, kFixed, kExp, kEmpirical };
+
+// How the service time is spent:
+//   spin  - calibrated busy-work on the serving thread (occupies a core)
+//   sleep - std::this_thread::sleep_for (frees the core, subject to timer slack)
+enum class ServiceMethod { kSpin, kSleep };
+
+inline const char* service_dist_name(ServiceDist d) {
+    switch (d) {
+        case ServiceDist::kNone: return "none";
+        case ServiceDist::kFixed: return "fixed";
+        case ServiceDist::kExp: return "exp";
+        case ServiceDist::kEmpirical: return "empirical";
+    }
+    return "?";
+}
+
+inline bool parse_service_dist(const std::string& s, ServiceDist& out) {
+    if (s == "none") {
+        out = ServiceDist::kNone;
+    } else if (s == "fixed") {
+        out = ServiceDist::kFixed;
+    } else if (s == "exp") {
+        out = ServiceDist::kExp;
+    } else if (s == "empirical") {
+        out = ServiceDist::kEmpirical;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline const char* service_method_name(ServiceMethod m) {
+    return (m == ServiceMethod::kSpin) ? "spin" : "sleep";
+}
+
+inline bool parse_service_method(const std::string& s, ServiceMethod& out) {
+    if (s == "spin") {
+        out = ServiceMethod::kSpin;
+    } else if (s == "sleep") {
+        out = ServiceMethod::kSleep;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+class ServiceModel {
+   public:
+    ServiceModel(ServiceDist dist, ServiceMethod method, double mean_us)
+        : dist_(dist), method_(method), mean_us_(mean_us) {}
+
+    // Reads one non-negative value (us) per line, see read_number_file().
+    bool load_empirical(const std::string& path, std::string& err) {
+        if (!read_number_file(path, samples_us_, err)) return false;
+        if (samples_us_.empty()) {
+            err = "no samples in " + path;
+            return false;
+        }
+        return true;
+    }
+
+    // Measures how many busy-work iterations take one microsecond. Only
+    // needed for ServiceMethod::kSpin.
+    void calibrate() {
+        if (dist_ == ServiceDist::kNone || method_ != ServiceMethod::kSpin) return;
+        const auto budget = std::chrono::milliseconds(50);
+        std::uint64_t iters = 0;
+        const auto t0 = std::chrono::steady_clock::now();
+        auto t1 = t0;
+        while (t1 - t0 < budget) {
+            busy_work(10000);
+            iters += 10000;
+            t1 = std::chrono::steady_clock::now();
+        }
+        const double us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+        iters_per_us_ = (us > 0.0) ? (static_cast<double>(iters) / us) : 1.0;
+    }
+
+    bool enabled() const { return dist_ != ServiceDist::kNone; }
+    ServiceDist dist() const { return dist_; }
+    ServiceMethod method() const { return method_; }
+    double mean_us() const { return mean_us_; }
+    double iters_per_us() const { return iters_per_us_; }
+    std::size_t empirical_size() const { return samples_us_.size(); }
+
+    // Draws the next target service time (us). Thread-safe.
+    double next_us() const {
+        switch (dist_) {
+            case ServiceDist::kNone: return 0.0;
+            case ServiceDist::kFixed: return mean_us_;
+            case ServiceDist::kExp: {
+                if (mean_us_ <= 0.0) return 0.0;
+                std::exponential_distribution<double> d(1.0 / mean_us_);
+                return d(rng());
+            }
+            case ServiceDist::kEmpirical: {
+                std::uniform_int_distribution<std::size_t> d(0, samples_us_.size() - 1);
+                return samples_us_[d(rng())];
+            }
+        }
+        return 0.0;
+    }
+
+    // Spends `us` microseconds on the calling thread.
+    void serve(double us) const {
+        if (us <= 0.0) return;
+        if (method_ == ServiceMethod::kSleep) {
+            std::this_thread::sleep_for(std::chrono::duration<double, std::micro>(us));
+        } else {
+            busy_work(static_cast<std::uint64_t>(us * iters_per_us_));
+        }
+    }
+
+   private:
+    static std::mt19937_64& rng() {
+        thread_local std::mt19937_64 gen(std::random_device{}());
+        return gen;
+    }
+
+    static void busy_work(std::uint64_t iters) {
+        std::uint64_t x = 0x9e3779b97f4a7c15ull;
+        for (std::uint64_t i = 0; i < iters; ++i) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+        }
+        sink_ = x;
+    }
+
+    static inline volatile std::uint64_t sink_ = 0;
+
+    ServiceDist dist_;
+    ServiceMethod method_;
+    double mean_us_;
+    double iters_per_us_ = 1.0;
+    std::vector<double> samples_us_;
+};
+
+}  // namespace bench
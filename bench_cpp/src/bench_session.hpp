@@ -0,0 +1,41 @@
+#pragma once
+
+#include "zenoh.hxx"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+// Splits a comma-separated option value (e.g. --connect endpoints).
+inline std::vector<std::string> split_csv(const std::string& s) {
+    std::vector<std::string> out;
+    std::size_t pos = 0;
+    while (pos <= s.size()) {
+        const std::size_t comma = s.find(',', pos);
+        const std::size_t end = (comma == std::string::npos) ? s.size() : comma;
+        if (end > pos) out.push_back(s.substr(pos, end - pos));
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return out;
+}
+
+// Key used by session `index` out of `count`. A single session keeps the base
+// key unchanged; with several, each one gets its own "<base>/s<index>" stream
+// so requests and ACKs stay on the session that carried them.
+inline std::string session_key(const std::string& base, std::size_t index, std::size_t count) {
+    if (count <= 1) return base;
+    return base + "/s" + std::to_string(index);
+}
+
+inline zenoh::Session open_session(const std::string& endpoint) {
+    zenoh::Config config = zenoh::Config::create_default();
+    const std::string endpoints_json = "[\"" + endpoint + "\"]";
+    config.insert_json5("connect/endpoints", endpoints_json);
+    return zenoh::Session::open(std::move(config));
+}
+
+}  // namespace bench